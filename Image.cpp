@@ -5,11 +5,20 @@ Image::Image(const char *fname, int row, int col) {
 	rows = row;
 	columns = col;
 	frameCounter = frame = animation = 0;
-	if (fname[0] == '\0')
+	width = height = 0;
+	data = 0;
+}
+
+Image::~Image() {
+	delete [] data;
+}
+
+void Image::load() {
+	if (data || file[0] == '\0')
 		return;
 	int ppm_flag = 0;
 	char name[40];
-	strcpy(name, fname);
+	strcpy(name, file);
 	int slen = strlen(name);
 	char ppm[80];
 	if (strncmp(name + (slen - 4), ".ppm", 4) == 0)
@@ -20,7 +29,7 @@ Image::Image(const char *fname, int row, int col) {
 		name[slen - 4] = '\0';
 		sprintf(ppm, "%s.ppm", name);
 		char ts[100];
-		sprintf(ts, "convert %s %s", fname, ppm);
+		sprintf(ts, "convert %s %s", file, ppm);
 		system(ts);
 	}
 	FILE *fpi = fopen (ppm, "r");
@@ -45,6 +54,7 @@ Image::Image(const char *fname, int row, int col) {
 		unlink(ppm);
 }
 
-Image::~Image() {
+void Image::freePixels() {
 	delete [] data;
+	data = 0;
 }
\ No newline at end of file
@@ -17,8 +17,13 @@ public:
 	int animation;
 	unsigned char *data;
 	const char *file;
+	//only remembers the file, nothing is read until load()
 	Image(const char* f, int r = 0, int c = 0);
 	~Image();
+	//decode the file into data, a no-op if it is already there
+	void load();
+	//drop the pixels once they are on the card, width and height stay
+	void freePixels();
 };
 
 #endif
\ No newline at end of file
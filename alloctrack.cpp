@@ -0,0 +1,127 @@
+//Program: alloctrack.cpp
+//Heap allocation counters for Shiba Survival
+//
+//Only built into the debug binary. malloc, calloc and realloc are
+//wrapped around glibc's own __libc_ versions, and operator new goes
+//straight to __libc_malloc so an allocation is never counted twice.
+//
+#ifdef DEBUG
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+#include "alloctrack.h"
+
+extern "C" {
+	void *__libc_malloc(size_t);
+	void *__libc_calloc(size_t, size_t);
+	void *__libc_realloc(void *, size_t);
+	void __libc_free(void *);
+}
+
+static const char *phaseNames[ALLOC_NPHASES] = {
+	"other", "physics", "render", "gameOver", "showScores"
+};
+
+//plain ints and atomics only, these are touched from inside malloc
+static thread_local int currentPhase = ALLOC_OTHER;
+static std::atomic<unsigned long> phaseCount[ALLOC_NPHASES];
+static std::atomic<unsigned long> phaseBytes[ALLOC_NPHASES];
+
+static inline void countAlloc(size_t bytes)
+{
+	phaseCount[currentPhase].fetch_add(1, std::memory_order_relaxed);
+	phaseBytes[currentPhase].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+extern "C" void *malloc(size_t bytes)
+{
+	countAlloc(bytes);
+	return __libc_malloc(bytes);
+}
+
+extern "C" void *calloc(size_t n, size_t size)
+{
+	countAlloc(n * size);
+	return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *p, size_t bytes)
+{
+	countAlloc(bytes);
+	return __libc_realloc(p, bytes);
+}
+
+void *operator new(size_t bytes)
+{
+	countAlloc(bytes);
+	void *p = __libc_malloc(bytes ? bytes : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t bytes)
+{
+	return operator new(bytes);
+}
+
+void operator delete(void *p) noexcept
+{
+	__libc_free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	__libc_free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	__libc_free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+	__libc_free(p);
+}
+
+AllocPhaseScope::AllocPhaseScope(int phase)
+{
+	saved = currentPhase;
+	currentPhase = phase;
+}
+
+AllocPhaseScope::~AllocPhaseScope()
+{
+	currentPhase = saved;
+}
+
+unsigned long allocTotal()
+{
+	unsigned long n = 0;
+	for (int i = 0; i < ALLOC_NPHASES; i++)
+		n += phaseCount[i].load(std::memory_order_relaxed);
+	return n;
+}
+
+void allocCounts(AllocCounts *out)
+{
+	for (int i = 0; i < ALLOC_NPHASES; i++) {
+		out[i].count = phaseCount[i].load(std::memory_order_relaxed);
+		out[i].bytes = phaseBytes[i].load(std::memory_order_relaxed);
+	}
+}
+
+void allocReport()
+{
+	AllocCounts c[ALLOC_NPHASES];
+	allocCounts(c);
+	printf("heap allocations by phase\n");
+	printf("%-12s %12s %14s\n", "phase", "count", "bytes");
+	for (int i = 0; i < ALLOC_NPHASES; i++)
+		printf("%-12s %12lu %14lu\n", phaseNames[i], c[i].count, c[i].bytes);
+}
+
+#endif
@@ -0,0 +1,51 @@
+//Program: alloctrack.h
+//Heap allocation counters for Shiba Survival
+//
+//In the debug build every operator new and malloc is counted against
+//the phase the calling thread is in, so the report at exit shows which
+//part of a frame still goes to the heap. ALLOC_PHASE(p) puts the rest
+//of the enclosing scope in phase p; phases nest, so the game over
+//screen drawn from render() counts as game over. The normal build has
+//no hooks and ALLOC_PHASE is empty.
+//
+#ifndef ALLOCTRACK_H
+#define ALLOCTRACK_H
+
+enum {
+	ALLOC_OTHER,
+	ALLOC_PHYSICS,
+	ALLOC_RENDER,
+	ALLOC_GAMEOVER,
+	ALLOC_SCORES,
+	ALLOC_NPHASES
+};
+
+struct AllocCounts {
+	unsigned long count;
+	unsigned long bytes;
+};
+
+#ifdef DEBUG
+
+class AllocPhaseScope {
+	private:
+		int saved;
+	public:
+		AllocPhaseScope(int phase);
+		~AllocPhaseScope();
+};
+
+#define ALLOC_PHASE(p) AllocPhaseScope allocPhaseScope(p)
+
+//allocations so far in every phase, all threads
+unsigned long allocTotal();
+void allocCounts(AllocCounts *out);
+void allocReport();
+
+#else
+
+#define ALLOC_PHASE(p)
+
+#endif
+
+#endif
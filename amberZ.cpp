@@ -4,133 +4,82 @@
  Personal functions for Shiba Survival
 **/
 
+#include <sys/stat.h>
+#include <unistd.h>
 #include "amberZ.h"
+#include "resolver.h"
 
 /*
  SSD: Class used to render the seven-segment display game timer
+ Segment bits run from bit 6, the top segment (a),
+ down to bit 0, the middle segment (g).
 **/
+static constexpr unsigned char ssdDigits[11] = {
+	0x7e, 0x30, 0x6d, 0x79, 0x33, 0x5b, 0x1f, 0x70, 0x7f, 0x73,
+	0x48
+};
+
+//one quad per segment, indexed by bit: {x0, y0, x1, y1}
+static constexpr float ssdSegments[7][4] = {
+	{ 0.0f, 50.0f, 40.0f,  60.0f},
+	{ 0.0f, 60.0f, 10.0f, 100.0f},
+	{ 0.0f, 10.0f, 10.0f,  50.0f},
+	{ 0.0f,  0.0f, 40.0f,  10.0f},
+	{30.0f, 10.0f, 40.0f,  50.0f},
+	{30.0f, 60.0f, 40.0f, 100.0f},
+	{ 0.0f,100.0f, 40.0f, 110.0f}
+};
+
+//the colon only uses the top (bit 6) and bottom (bit 3) dots
+static constexpr float ssdColon[7][4] = {
+	{0}, {0}, {0},
+	{ 0.0f, 10.0f, 10.0f,  20.0f},
+	{0}, {0},
+	{ 0.0f, 90.0f, 10.0f, 100.0f}
+};
+
 SSD::SSD()
 {
-	screen = std::bitset<7>("1111110");
+	screen = ssdDigits[0];
 }
 
 void SSD::updateDisplay(int num)
 {
-	switch (num) {
-		case 0:
-			screen = std::bitset<7>("1111110");
-			break;
-		case 1:
-			screen = std::bitset<7>("0110000");
-			break;
-		case 2:
-			screen = std::bitset<7>("1101101");
-			break;
-		case 3:
-			screen = std::bitset<7>("1111001");
-			break;
-		case 4:
-			screen = std::bitset<7>("0110011");
-			break;
-		case 5:
-			screen = std::bitset<7>("1011011");
-			break;
-		case 6:
-			screen = std::bitset<7>("0011111");
-			break;
-		case 7:
-			screen = std::bitset<7>("1110000");
-			break;
-		case 8:
-			screen = std::bitset<7>("1111111");
-			break;
-		case 9:
-			screen = std::bitset<7>("1110011");
-			break;
-		default:
-			screen = std::bitset<7>("1001000");
-			break;
-	}
+	if (num < 0 || num > 9)
+		num = 10;
+	screen = ssdDigits[num];
 }
 
-void SSD::renderSSD()
+/*
+ buildSegments(): Writes a quad for every lit segment into verts,
+ offset by xoff, and returns the number of vertices written
+**/
+static int buildSegments(unsigned char mask, const float seg[7][4],
+	float xoff, float *verts)
 {
-	if (screen[6]) {
-		glBegin(GL_POLYGON);
-			glVertex2f(0.0f, 100.0f);
-			glVertex2f(0.0f, 110.0f);
-			glVertex2f(40.0f, 110.0f);
-			glVertex2f(40.0f, 100.0f);
-		glEnd();
-	}
-	if (screen[5]) {
-		glBegin(GL_POLYGON);
-			glVertex2f(30.0f, 60.0f);
-			glVertex2f(30.0f, 100.0f);
-			glVertex2f(40.0f, 100.0f);
-			glVertex2f(40.0f, 60.0f);
-		glEnd();
-	}
-	if (screen[4]) {
-		glBegin(GL_POLYGON);
-			glVertex2f(30.0f, 10.0f);
-			glVertex2f(30.0f, 50.0f);
-			glVertex2f(40.0f, 50.0f);
-			glVertex2f(40.0f, 10.0f);
-		glEnd();
-	}
-	if (screen[3]) {
-		glBegin(GL_POLYGON);
-			glVertex2f(0.0f, 0.0f);
-			glVertex2f(0.0f, 10.0f);
-			glVertex2f(40.0f, 10.0f);
-			glVertex2f(40.0f, 0.0f);
-		glEnd();
-	}
-	if (screen[2]) {
-		glBegin(GL_POLYGON);
-			glVertex2f(0.0f, 10.0f);
-			glVertex2f(0.0f, 50.0f);
-			glVertex2f(10.0f, 50.0f);
-			glVertex2f(10.0f, 10.0f);
-		glEnd();
-	}
-	if (screen[1]) {
-		glBegin(GL_POLYGON);
-			glVertex2f(0.0f, 60.0f);
-			glVertex2f(0.0f, 100.0f);
-			glVertex2f(10.0f, 100.0f);
-			glVertex2f(10.0f, 60.0f);
-		glEnd();
-	}
-	if (screen[0]) {
-		glBegin(GL_POLYGON);
-			glVertex2f(0.0f, 50.0f);
-			glVertex2f(0.0f, 60.0f);
-			glVertex2f(40.0f, 60.0f);
-			glVertex2f(40.0f, 50.0f);
-		glEnd();
+	int n = 0;
+	for (int i = 6; i >= 0; i--) {
+		if (!(mask & (1 << i)) || seg[i][2] == 0.0f)
+			continue;
+		float x0 = seg[i][0] + xoff, x1 = seg[i][2] + xoff;
+		float y0 = seg[i][1], y1 = seg[i][3];
+		verts[n * 2 + 0] = x0; verts[n * 2 + 1] = y0;
+		verts[n * 2 + 2] = x0; verts[n * 2 + 3] = y1;
+		verts[n * 2 + 4] = x1; verts[n * 2 + 5] = y1;
+		verts[n * 2 + 6] = x1; verts[n * 2 + 7] = y0;
+		n += 4;
 	}
+	return n;
 }
 
-void SSD::renderColon()
+int SSD::buildSSD(float xoff, float *verts)
 {
-	if (screen[6]) {
-		glBegin(GL_POLYGON);
-			glVertex2f(0.0f, 90.0f);
-			glVertex2f(0.0f, 100.0f);
-			glVertex2f(10.0f, 100.0f);
-			glVertex2f(10.0f, 90.0f);
-		glEnd();
-	}
-	if (screen[3]) {
-		glBegin(GL_POLYGON);
-			glVertex2f(0.0f, 20.0f);
-			glVertex2f(0.0f, 10.0f);
-			glVertex2f(10.0f, 10.0f);
-			glVertex2f(10.0f, 20.0f);
-		glEnd();
-	}
+	return buildSegments(screen, ssdSegments, xoff, verts);
+}
+
+int SSD::buildColon(float xoff, float *verts)
+{
+	return buildSegments(screen, ssdColon, xoff, verts);
 }
 
 /*
@@ -148,16 +97,35 @@ void SSDTimer::stopTimer()
 	isRunning = false;
 }
 
+/*
+ pauseTimer()/resumeTimer(): freeze the timer while the game is paused,
+ resuming shifts the start time so the paused span is not counted
+**/
+void SSDTimer::pauseTimer()
+{
+	if (isRunning) {
+		stopTimer();
+	}
+}
+
+void SSDTimer::resumeTimer()
+{
+	if (!isRunning) {
+		startTime += std::chrono::system_clock::now() - endTime;
+		isRunning = true;
+	}
+}
+
 double SSDTimer::getElapsedMilliseconds()
 {
-	std::chrono::time_point<std::chrono::system_clock> endTime;
+	std::chrono::time_point<std::chrono::system_clock> end;
 	if (isRunning) {
-		endTime = std::chrono::system_clock::now();
+		end = std::chrono::system_clock::now();
 	}
 	else {
-		endTime = endTime;
+		end = endTime;
 	}
-	return std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+	return std::chrono::duration_cast<std::chrono::milliseconds>(end - startTime).count();
 }
 
 double SSDTimer::getElapsedSeconds()
@@ -170,6 +138,13 @@ double SSDTimer::getElapsedMinutes()
 	return getElapsedSeconds() / 60.0;
 }
 
+void SSDTimer::setElapsedMilliseconds(double ms)
+{
+	startTime = std::chrono::system_clock::now() -
+		std::chrono::milliseconds((long long)ms);
+	endTime = std::chrono::system_clock::now();
+}
+
 /*
  SpriteTimer: Class used to handle the sprite animation speed
 **/
@@ -196,54 +171,44 @@ AmbersGlobals *ag = ag->getInstance();
 
 /*
  drawTimer(): Function used to render the SSD timer
+ All lit segments are drawn from the cached vertex array in one call
 **/
 void drawTimer(int xres)
 {
+	if (ag->timerVertCount == 0)
+		return;
 	glColor3f(1.0f, 1.0f, 1.0f);
 	glPushMatrix();
-		glTranslated((xres / 2) - 100, 595.0f, 0.0f);
-		ag->minute1.renderSSD();
-	glPopMatrix();
-	glPushMatrix();
-		glTranslated((xres / 2) - 50, 595.0f, 0.0f);
-		ag->minute2.renderSSD();
-	glPopMatrix();
-	glPushMatrix();
-		glTranslated((xres / 2), 595.0f, 0.0f);
-		ag->colon.renderColon();
-		ag->colon.updateDisplay(10);
-	glPopMatrix();
-	glPushMatrix();
-		glTranslated((xres / 2) + 20, 595.0f, 0.0f);
-		ag->second1.renderSSD();
-	glPopMatrix();
-	glPushMatrix();
-		glTranslated((xres / 2) + 70, 595.0f, 0.0f);
-		ag->second2.renderSSD();
+		glTranslated(xres / 2, 595.0f, 0.0f);
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glVertexPointer(2, GL_FLOAT, 0, ag->timerVerts);
+		glDrawArrays(GL_QUADS, 0, ag->timerVertCount);
+		glDisableClientState(GL_VERTEX_ARRAY);
 	glPopMatrix();
 }
 
 /*
  updateTimer(): Function used to update the SSD timer
+ The vertex array is only rebuilt when the displayed time changes
 **/
 void updateTimer(int min, int sec)
 {
-	if (min > 9) {
-		ag->minute1.updateDisplay(min / 10);
-		ag->minute2.updateDisplay(min % 10);
-	}
-	else {
-		ag->minute1.updateDisplay(0);
-		ag->minute2.updateDisplay(min);
-	}
-	if (sec > 9) {
-		ag->second1.updateDisplay(sec / 10);
-		ag->second2.updateDisplay(sec % 10);
-	}
-	else {
-		ag->second1.updateDisplay(0);
-		ag->second2.updateDisplay(sec);
-	}
+	if (min == ag->shownMinute && sec == ag->shownSecond)
+		return;
+	ag->shownMinute = min;
+	ag->shownSecond = sec;
+	ag->minute1.updateDisplay((min / 10) % 10);
+	ag->minute2.updateDisplay(min % 10);
+	ag->second1.updateDisplay(sec / 10);
+	ag->second2.updateDisplay(sec % 10);
+	float *v = ag->timerVerts;
+	int n = 0;
+	n += ag->minute1.buildSSD(-100.0f, v + n * 2);
+	n += ag->minute2.buildSSD(-50.0f, v + n * 2);
+	n += ag->colon.buildColon(0.0f, v + n * 2);
+	n += ag->second1.buildSSD(20.0f, v + n * 2);
+	n += ag->second2.buildSSD(70.0f, v + n * 2);
+	ag->timerVertCount = n;
 }
 
 /*
@@ -323,7 +288,8 @@ void amberZ(int x, int y, GLuint textureId)
 	r.bot = y;
 	r.left = x + 90;
 	r.center = 0;
-	ggprint16(&r, 16, 0x00ffffff, "Amber Zaragoza");
+	static TextLabel name;
+	name.print(&r, 16, 0x00ffffff, "Amber Zaragoza");
 }
 
 BIO *sslSetupBIO(void)
@@ -353,10 +319,11 @@ void setNonBlocking(const int sock)
 	}
 }
 
-void connectToWebsite(char user[], int score)
+//sendScore(): the blocking part of a submission, once the host name is
+//already known
+static void sendScore(struct in_addr ip, const char user[], int score)
 {
 	int sd;
-	struct hostent *host;
 	struct sockaddr_in addr;
 	BIO *outbio = NULL;
 	const SSL_METHOD *method;
@@ -364,11 +331,10 @@ void connectToWebsite(char user[], int score)
 	SSL *ssl;
 	char req[1000];
 	int req_len;
-	char hostname[256] = "cs.csubak.edu";
+	const char *hostname = ag->scoreHost;
 	char pagename[256];
-	sprintf(pagename, 
-		"~azaragoza/Shiba-Survival/save_scores.php?user=%s&score=%d",
-		user, score);
+	snprintf(pagename, sizeof(pagename), "%s?user=%s&score=%d",
+		ag->scorePage, user, score);
 	int port = ag->port;
 	int ret;
 	outbio = sslSetupBIO();
@@ -378,12 +344,11 @@ void connectToWebsite(char user[], int score)
 	method = SSLv23_client_method();
 	ctx = SSL_CTX_new(method);
 	SSL_CTX_set_options(ctx, SSL_OP_NO_SSLv2);
-	host = gethostbyname(hostname);
 	sd = socket(AF_INET, SOCK_STREAM, 0);
 	memset(&addr, 0, sizeof(addr));
 	addr.sin_family = AF_INET;
 	addr.sin_port = htons(port);
-	addr.sin_addr.s_addr = *(long*)(host->h_addr);
+	addr.sin_addr = ip;
 	if (connect(sd, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
 		BIO_printf(outbio, "%s: Cannot connect to host %s [%s] on port %d.\n",
 			hostname, hostname, inet_ntoa(addr.sin_addr), port);
@@ -393,7 +358,7 @@ void connectToWebsite(char user[], int score)
 	SSL_connect(ssl);
 	setNonBlocking(sd);
 	sprintf(req, "GET /%s HTTP/1.1\r\nUser-Agent: %s\r\nHost: %s\r\n\r\n",
-		pagename, hostname, ag->userAgent);
+		pagename, ag->userAgent, hostname);
 	req_len = strlen(req);
 	ret = SSL_write(ssl, req, req_len);
 	if (ret <= 0) {
@@ -405,6 +370,50 @@ void connectToWebsite(char user[], int score)
 	SSL_CTX_free(ctx);
 }
 
+//scores waiting on the resolver, sent by flushScoreQueue()
+struct ScoreSubmission {
+	char user[64];
+	int score;
+};
+static std::vector<ScoreSubmission> scoreQueue;
+
+//connectToWebsite(): sends the score now if the host name is cached,
+//otherwise leaves it for flushScoreQueue() so the game never waits on DNS
+void connectToWebsite(char user[], int score)
+{
+	struct in_addr ip;
+	int state = resolver.lookup(ag->scoreHost, &ip);
+	if (state == RESOLVE_OK && scoreQueue.empty()) {
+		sendScore(ip, user, score);
+		return;
+	}
+	if (state == RESOLVE_FAILED) {
+		printf("Cannot find %s, score not sent\n", ag->scoreHost);
+		return;
+	}
+	ScoreSubmission s;
+	snprintf(s.user, sizeof(s.user), "%s", user);
+	s.score = score;
+	scoreQueue.push_back(s);
+}
+
+void flushScoreQueue()
+{
+	if (scoreQueue.empty())
+		return;
+	struct in_addr ip;
+	int state = resolver.lookup(ag->scoreHost, &ip);
+	if (state == RESOLVE_PENDING)
+		return;
+	for (unsigned int i = 0; i < scoreQueue.size(); i++) {
+		if (state == RESOLVE_OK)
+			sendScore(ip, scoreQueue[i].user, scoreQueue[i].score);
+		else
+			printf("Cannot find %s, score not sent\n", ag->scoreHost);
+	}
+	scoreQueue.clear();
+}
+
 void storeScore(char user[], int score)
 {
 	std::ofstream file;
@@ -425,34 +434,79 @@ bool sortbysec(const std::pair<std::string, int> &a, const
 	return (a.second > b.second); 
 }
 
-void getTopScores()
+/*
+ readScores: reads scores.csv into the frame arena in one piece and
+ splits it in place, so the rows only last until the arena is reset.
+ A plain descriptor, since a FILE puts itself and its buffer on the heap.
+**/
+void readScores(ArenaVector<ScoreRow> &rows)
 {
-	ag->scores.clear();
-	std::pair<std::string, int> p;
-	std::ifstream file("scores.csv");
-	std::string line;
-	std::string name;
-	int score;
-	if (file.peek() != '\0') {
-		while (getline(file, line)) {
-			std::stringstream ss(line);
-			std::string value;
-			while (std::getline(ss, value, ',')) {
-				try {
-					name = value;
-					std::getline(ss, value, ',');
-					score = stod(value);
-					p.first = name;
-					p.second = score;
-					ag->scores.push_back(p);
-				}
-				catch (...) {
-					break;
-				}
+	rows.clear();
+	int fd = open("scores.csv", O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size <= 0) {
+		close(fd);
+		return;
+	}
+	long len = st.st_size;
+	char *text = (char *) frameArena.alloc(len + 1);
+	long got = 0;
+	while (got < len) {
+		ssize_t n = read(fd, text + got, len - got);
+		if (n <= 0) {
+			break;
+		}
+		got += n;
+	}
+	close(fd);
+	len = got;
+	text[len] = '\0';
+	int lines = 1;
+	for (long i = 0; i < len; i++) {
+		lines += (text[i] == '\n');
+	}
+	rows.reserve(lines);
+	char *line = text;
+	while (*line) {
+		char *end = strchr(line, '\n');
+		if (end) {
+			*end = '\0';
+		}
+		//name,score and nothing else counts
+		char *comma = strchr(line, ',');
+		if (comma) {
+			*comma = '\0';
+			char *stop;
+			double score = strtod(comma + 1, &stop);
+			if (stop != comma + 1) {
+				ScoreRow row = {line, (int) score};
+				rows.push_back(row);
 			}
 		}
-		sort(ag->scores.begin(), ag->scores.end(), sortbysec);
+		if (!end) {
+			break;
+		}
+		line = end + 1;
+	}
+}
+
+void getTopScores()
+{
+	ArenaScope scope;
+	ArenaVector<ScoreRow> rows;
+	readScores(rows);
+	//assign() keeps each name's buffer when the list is read again
+	ag->scores.resize(rows.size());
+	for (unsigned int i = 0; i < rows.size(); i++) {
+		ag->scores[i].first.assign(rows[i].name);
+		std::transform(ag->scores[i].first.begin(), ag->scores[i].first.end(),
+			ag->scores[i].first.begin(), ::toupper);
+		ag->scores[i].second = rows[i].score;
 	}
+	sort(ag->scores.begin(), ag->scores.end(), sortbysec);
 }
 
 int getRanking(std::string user, int score)
@@ -468,29 +522,30 @@ int getRanking(std::string user, int score)
 
 void showScores()
 {
+	ALLOC_PHASE(ALLOC_SCORES);
 	if (ag->topScores) {
 		getTopScores();
 		ag->topScores = 0;
 		//std::cout << getRanking("anonymous", 25369) << std::endl;
 	}
-  glClear(GL_COLOR_BUFFER_BIT);
+	static TextLabel title, name[10], score[10], footer[2];
+	glClear(GL_COLOR_BUFFER_BIT);
+	textDiscard();
 	Rect r;
 	r.left = 635;
 	r.bot = ag->yres - 100;
 	r.center = 0;
 	if (!ag->scores.empty()) {
-		ggprint16(&r, 0, 0x00ffffff, "Local High Scores");
+		title.print(&r, 0, 0x00ffffff, "Local High Scores");
 		r.bot = ag->yres - 150;
 		int leftCol = ag->xres/2 - 100;
 		int rightCol = ag->xres/2 + 115;
 		for (int i = 0; i < 10; i++) {
 			if (i < (int) ag->scores.size()) {
 				r.left = leftCol;
-				std::transform(ag->scores[i].first.begin(), ag->scores[i].first.end(),
-					ag->scores[i].first.begin(), ::toupper);
-				ggprint16(&r, 0, 0x00ffffff, ag->scores[i].first.c_str());
+				name[i].print(&r, 0, 0x00ffffff, "%s", ag->scores[i].first.c_str());
 				r.left = rightCol;
-				ggprint16(&r, 0, 0x00ffffff, "%d", ag->scores[i].second);
+				score[i].print(&r, 0, 0x00ffffff, "%d", ag->scores[i].second);
 				r.bot -= 50;
 			} else {
 				break;
@@ -498,8 +553,8 @@ void showScores()
 		}
 	}
 	r.left = 620;
-	ggprint16(&r, 0, 0x00ffffff, "View more scores at");
+	footer[0].print(&r, 0, 0x00ffffff, "View more scores at");
 	r.left = ag->xres/2 - 180;
 	r.bot -= 30;
-	ggprint16(&r, 0, 0x00ffffff, "https://cs.csubak.edu/~azaragoza/Shiba-Survival/");
+	footer[1].print(&r, 0, 0x00ffffff, "https://cs.csubak.edu/~azaragoza/Shiba-Survival/");
 }
\ No newline at end of file
@@ -26,18 +26,24 @@
 #include "amberZ.h"
 #include "Image.h"
 #include "fonts.h"
+#include "text.h"
+#include "arena.h"
+#include "alloctrack.h"
 
 class SSD
 {
 	private:
-		std::bitset<7> screen;
+		unsigned char screen;
 	public:
 		SSD();
 		void updateDisplay(int);
-		void renderSSD();
-		void renderColon();
+		int buildSSD(float, float*);
+		int buildColon(float, float*);
 };
 
+//4 digits of 7 segments plus the 2 colon dots, 4 vertices each
+#define SSD_MAX_VERTS ((4 * 7 + 2) * 4)
+
 class SSDTimer
 {
   private:
@@ -47,9 +53,13 @@ class SSDTimer
   public:
 		void startTimer();
 		void stopTimer();
+		void pauseTimer();
+		void resumeTimer();
 		double getElapsedMilliseconds();
 		double getElapsedSeconds();
 		double getElapsedMinutes();
+		//picks a resumed game up at the time it was saved
+		void setElapsedMilliseconds(double);
 };
 
 class SpriteTimer {
@@ -76,7 +86,13 @@ class AmbersGlobals {
 		SSD second1;
 		SSD second2;
 		SSDTimer gameTimer;
+		float timerVerts[SSD_MAX_VERTS * 2];
+		int timerVertCount;
+		int shownMinute;
+		int shownSecond;
 		int port;
+		char *scoreHost;
+		char *scorePage;
 		char *userAgent;
 		int maxReadErrors;
 		int topScores;
@@ -92,9 +108,22 @@ class AmbersGlobals {
 			xres = 1366;
 			yres = 766;
 			port = 443;
+			scoreHost = (char *) "cs.csubak.edu";
+			scorePage = (char *) "~azaragoza/Shiba-Survival/save_scores.php";
+			//SHIBA_SCORE_HOST, _PORT and _PAGE send scores somewhere
+			//else, such as a scoreserver on the local network
+			if (getenv("SHIBA_SCORE_HOST"))
+				scoreHost = getenv("SHIBA_SCORE_HOST");
+			if (getenv("SHIBA_SCORE_PORT"))
+				port = atoi(getenv("SHIBA_SCORE_PORT"));
+			if (getenv("SHIBA_SCORE_PAGE"))
+				scorePage = getenv("SHIBA_SCORE_PAGE");
 			userAgent = (char *) "CMPS-3350";
 			maxReadErrors = 100;
 			topScores = 1;
+			timerVertCount = 0;
+			shownMinute = shownSecond = -1;
+			colon.updateDisplay(10);
 		}
 };
 
@@ -105,10 +134,18 @@ void updateFrame(Image&, SpriteTimer&, double);
 void amberZ(int, int, GLuint);
 BIO *sslSetupBIO(void);
 void setNonBlocking(const int);
-void connectToWebsite(char[], char[]);
+void connectToWebsite(char[], int);
+//sends scores that were waiting on the host name, called every frame
+void flushScoreQueue();
 bool sortbysec(const std::pair<std::string, int>&, const std::pair<std::string, int>&);
 void storeScore(char[], int);
 void getTopScores();
+//one line of scores.csv, name points into the frame arena
+struct ScoreRow {
+	const char *name;
+	int score;
+};
+void readScores(ArenaVector<ScoreRow> &);
 int getRanking(std::string, int);
 void showScores();
 
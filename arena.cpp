@@ -0,0 +1,77 @@
+//Program: arena.cpp
+//Frame arena for Shiba Survival
+//
+#include <stdlib.h>
+#include "arena.h"
+
+FrameArena frameArena;
+
+FrameArena::FrameArena()
+{
+	capacity = ARENA_DEFAULT_SIZE;
+	block = (char *)malloc(capacity);
+	top = 0;
+	peak = 0;
+	spilled = 0;
+}
+
+FrameArena::~FrameArena()
+{
+	for (unsigned int i = 0; i < overflow.size(); i++)
+		free(overflow[i]);
+	free(block);
+}
+
+void *FrameArena::alloc(size_t bytes)
+{
+	bytes = (bytes + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+	if (top + bytes <= capacity) {
+		void *p = block + top;
+		top += bytes;
+		if (top > peak)
+			peak = top;
+		return p;
+	}
+	//out of room this frame, borrow from the heap until reset()
+	void *p = malloc(bytes);
+	overflow.push_back(p);
+	spilled += bytes;
+	return p;
+}
+
+ArenaMark FrameArena::mark() const
+{
+	ArenaMark m;
+	m.top = top;
+	m.spills = overflow.size();
+	return m;
+}
+
+void FrameArena::release(const ArenaMark &mark)
+{
+	if (mark.top < top)
+		top = mark.top;
+	//spilled is left alone, reset() still grows the block to fit
+	for (size_t i = mark.spills; i < overflow.size(); i++)
+		free(overflow[i]);
+	if (mark.spills < overflow.size())
+		overflow.resize(mark.spills);
+}
+
+void FrameArena::reset()
+{
+	for (unsigned int i = 0; i < overflow.size(); i++)
+		free(overflow[i]);
+	overflow.clear();
+	if (spilled > 0) {
+		//grow once so the same frame fits next time
+		size_t want = capacity;
+		while (want < peak + spilled)
+			want *= 2;
+		free(block);
+		block = (char *)malloc(want);
+		capacity = want;
+		spilled = 0;
+	}
+	top = 0;
+}
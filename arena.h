@@ -0,0 +1,84 @@
+//Program: arena.h
+//Frame arena for Shiba Survival
+//
+//Scratch memory that only has to last until the end of the frame comes
+//from one block that is handed out front to back and taken back all at
+//once by reset() at the top of the next frame. Handing out memory is a
+//pointer bump and giving it back is free, so a screen that builds
+//strings or lists every frame stops touching the heap once the block
+//is big enough.
+//
+//If the block runs out, the extra comes from the heap and is freed at
+//the next reset, and the block grows to fit so later frames stay on it.
+//ArenaScope gives back everything taken since it was made, for scratch
+//that is only needed inside one function. That includes heap it spilled
+//into, so a loop that never reaches a reset (the stress ladder, say)
+//does not keep every spill until the end of the run.
+//
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <vector>
+
+#define ARENA_DEFAULT_SIZE (256 * 1024)
+#define ARENA_ALIGN 16
+
+//where the arena was, to go back to
+struct ArenaMark {
+	size_t top;
+	size_t spills;
+};
+
+class FrameArena {
+	private:
+		char *block;
+		size_t capacity;
+		size_t top;
+		size_t peak;
+		size_t spilled;
+		std::vector<void *> overflow;
+	public:
+		FrameArena();
+		~FrameArena();
+		void *alloc(size_t bytes);
+		ArenaMark mark() const;
+		//give back everything allocated since mark, spills included
+		void release(const ArenaMark &mark);
+		//start of a frame: everything goes back
+		void reset();
+		size_t used() const { return top; }
+		size_t size() const { return capacity; }
+		size_t peakUsed() const { return peak; }
+};
+
+extern FrameArena frameArena;
+
+//lets std containers and strings live in the frame arena. Freeing is a
+//no-op, the memory comes back at reset() or at the end of an ArenaScope.
+template <class T>
+struct ArenaAllocator {
+	typedef T value_type;
+	ArenaAllocator() {}
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U> &) {}
+	T *allocate(size_t n) { return (T *)frameArena.alloc(n * sizeof(T)); }
+	void deallocate(T *, size_t) {}
+	template <class U>
+	bool operator==(const ArenaAllocator<U> &) const { return true; }
+	template <class U>
+	bool operator!=(const ArenaAllocator<U> &) const { return false; }
+};
+
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+
+class ArenaScope {
+	private:
+		ArenaMark start;
+	public:
+		ArenaScope() { start = frameArena.mark(); }
+		~ArenaScope() { frameArena.release(start); }
+};
+
+#endif
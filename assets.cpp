@@ -0,0 +1,328 @@
+//Program: assets.cpp
+//Texture residency for Shiba Survival
+//
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "assets.h"
+#include "log.h"
+
+AssetManager assets;
+
+static double monotonicSeconds()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static const char *formatNames[] = { "RGB8", "RGB5", "RGB5_A1", "palette" };
+
+//PaletteTable: colours seen so far, open addressed on the RGB value
+struct PaletteTable {
+	//colour + 1, 0 for an empty slot
+	unsigned int key[1024];
+	unsigned char index[1024];
+	unsigned int colour[256];
+	int count;
+	PaletteTable() {
+		memset(key, 0, sizeof key);
+		count = 0;
+	}
+	//find(): palette index of c, -1 once there are too many colours
+	int find(unsigned int c) {
+		unsigned int slot = (c * 2654435761u) >> 22;
+		while (key[slot]) {
+			if (key[slot] == c + 1)
+				return index[slot];
+			slot = (slot + 1) & 1023;
+		}
+		if (count == 256)
+			return -1;
+		key[slot] = c + 1;
+		index[slot] = count;
+		colour[count] = c;
+		return count++;
+	}
+};
+
+static inline unsigned int rgbAt(const unsigned char *p)
+{
+	return (p[0] << 16) | (p[1] << 8) | p[2];
+}
+
+//buildIndexed(): one byte a pixel for the w by h block at x0, y0, or
+//false if it has more than 256 colours
+static bool buildIndexed(const Image *img, int x0, int y0, int w, int h,
+	unsigned char *out, PaletteTable &pal)
+{
+	for (int y = 0; y < h; y++) {
+		const unsigned char *p = img->data + ((y0 + y) * img->width + x0) * 3;
+		for (int x = 0; x < w; x++, p += 3) {
+			int i = pal.find(rgbAt(p));
+			if (i < 0)
+				return false;
+			*out++ = i;
+		}
+	}
+	return true;
+}
+
+//buildPacked(): two bytes a pixel, 5-5-5-1 with the key colour clear
+//when keyed, otherwise 5-6-5
+static void buildPacked(const Image *img, int x0, int y0, int w, int h,
+	bool keyed, unsigned short *out)
+{
+	unsigned int key = rgbAt(img->data);
+	for (int y = 0; y < h; y++) {
+		const unsigned char *p = img->data + ((y0 + y) * img->width + x0) * 3;
+		for (int x = 0; x < w; x++, p += 3) {
+			if (keyed)
+				*out++ = ((p[0] >> 3) << 11) | ((p[1] >> 3) << 6) |
+					((p[2] >> 3) << 1) | (rgbAt(p) != key);
+			else
+				*out++ = ((p[0] >> 3) << 11) | ((p[1] >> 2) << 5) |
+					(p[2] >> 3);
+		}
+	}
+}
+
+AssetManager::AssetManager()
+{
+	budget = (long)ASSET_BUDGET_MB << 20;
+	resident = 0;
+	peak = 0;
+	clock = 0;
+}
+
+void AssetManager::setBudget(long bytes)
+{
+	budget = bytes;
+	trim();
+}
+
+int AssetManager::add(Image *image, int flags)
+{
+	for (unsigned int i = 0; i < assets.size(); i++) {
+		if (strcmp(assets[i].image->file, image->file) == 0)
+			return i;
+	}
+	Asset a;
+	a.image = image;
+	a.flags = flags;
+	glGenTextures(1, &a.texture);
+	glBindTexture(GL_TEXTURE_2D, a.texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	a.u0 = a.v0 = 0.0f;
+	a.u1 = a.v1 = 1.0f;
+	a.resident = false;
+	a.refs = 0;
+	a.bytes = 0;
+	a.plainBytes = 0;
+	a.sentBytes = 0;
+	a.format = ASSET_RGB8;
+	a.colours = 0;
+	a.lastUsed = 0;
+	a.uploads = 0;
+	a.uploadSeconds = 0.0;
+	assets.push_back(a);
+	return assets.size() - 1;
+}
+
+void AssetManager::crop(int h, float u0, float v0, float u1, float v1)
+{
+	Asset &a = assets[h];
+	a.u0 = u0;
+	a.v0 = v0;
+	a.u1 = u1;
+	a.v1 = v1;
+}
+
+//load(): decode, crop, pick the smallest format that keeps every
+//colour drawn, upload and drop the pixels again
+void AssetManager::load(Asset &a)
+{
+	double start = monotonicSeconds();
+	Image *img = a.image;
+	img->load();
+	bool keyed = a.flags & ASSET_COLORKEY;
+	int x0 = (int)(a.u0 * img->width + 0.5f);
+	int y0 = (int)(a.v0 * img->height + 0.5f);
+	int w = (int)(a.u1 * img->width + 0.5f) - x0;
+	int h = (int)(a.v1 * img->height + 0.5f) - y0;
+	long pixels = (long)w * h;
+	a.plainBytes = (long)img->width * img->height * (keyed ? 4 : 3);
+	glBindTexture(GL_TEXTURE_2D, a.texture);
+	//rows of one and two byte pixels are not padded to four bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	PaletteTable *pal = new PaletteTable;
+	unsigned char *indexed = new unsigned char[pixels];
+	if (buildIndexed(img, x0, y0, w, h, indexed, *pal)) {
+		//the card looks every byte up in these maps as it is sent
+		float map[4][256];
+		memset(map, 0, sizeof map);
+		unsigned int key = rgbAt(img->data);
+		for (int i = 0; i < pal->count; i++) {
+			unsigned int c = pal->colour[i];
+			map[0][i] = ((c >> 16) & 0xff) / 255.0f;
+			map[1][i] = ((c >> 8) & 0xff) / 255.0f;
+			map[2][i] = (c & 0xff) / 255.0f;
+			map[3][i] = (keyed && c == key) ? 0.0f : 1.0f;
+		}
+		glPixelMapfv(GL_PIXEL_MAP_I_TO_R, 256, map[0]);
+		glPixelMapfv(GL_PIXEL_MAP_I_TO_G, 256, map[1]);
+		glPixelMapfv(GL_PIXEL_MAP_I_TO_B, 256, map[2]);
+		glPixelMapfv(GL_PIXEL_MAP_I_TO_A, 256, map[3]);
+		GLint internal = keyed ? GL_RGB5_A1 :
+			(a.flags & ASSET_16BIT) ? GL_RGB5 : GL_RGB8;
+		glTexImage2D(GL_TEXTURE_2D, 0, internal, w, h, 0, GL_COLOR_INDEX,
+			GL_UNSIGNED_BYTE, indexed);
+		a.format = ASSET_PALETTE;
+		a.colours = pal->count;
+		a.sentBytes = pixels;
+		a.bytes = pixels * (internal == GL_RGB8 ? 3 : 2);
+	} else if (keyed || (a.flags & ASSET_16BIT)) {
+		unsigned short *packed = new unsigned short[pixels];
+		buildPacked(img, x0, y0, w, h, keyed, packed);
+		if (keyed)
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB5_A1, w, h, 0, GL_RGBA,
+				GL_UNSIGNED_SHORT_5_5_5_1, packed);
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB5, w, h, 0, GL_RGB,
+				GL_UNSIGNED_SHORT_5_6_5, packed);
+		delete [] packed;
+		a.format = keyed ? ASSET_RGB5A1 : ASSET_RGB5;
+		a.colours = 0;
+		a.sentBytes = pixels * 2;
+		a.bytes = pixels * 2;
+	} else {
+		//plenty of colours and every bit wanted, only the crop helps
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, img->width);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, w, h, 0, GL_RGB,
+			GL_UNSIGNED_BYTE, img->data + (y0 * img->width + x0) * 3);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		a.format = ASSET_RGB8;
+		a.colours = 0;
+		a.sentBytes = pixels * 3;
+		a.bytes = pixels * 3;
+	}
+	delete [] indexed;
+	delete pal;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	//the card has its own copy now
+	img->freePixels();
+	a.resident = true;
+	a.uploads++;
+	a.uploadSeconds += monotonicSeconds() - start;
+	resident += a.bytes;
+	if (resident > peak)
+		peak = resident;
+	Log("assets: loaded %s as %s, %ld kB\n", img->file,
+		formatNames[a.format], a.bytes >> 10);
+}
+
+//evict(): frees the storage and keeps the name
+void AssetManager::evict(Asset &a)
+{
+	glBindTexture(GL_TEXTURE_2D, a.texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 0, 0, 0, GL_RGBA,
+		GL_UNSIGNED_BYTE, NULL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	a.resident = false;
+	resident -= a.bytes;
+	Log("assets: dropped %s, %ld kB\n", a.image->file, a.bytes >> 10);
+}
+
+//trim(): drops released textures, longest unused first, until the
+//ones left fit the budget
+void AssetManager::trim()
+{
+	while (resident > budget) {
+		Asset *oldest = NULL;
+		for (unsigned int i = 0; i < assets.size(); i++) {
+			Asset &a = assets[i];
+			if (a.resident && a.refs == 0 &&
+					(!oldest || a.lastUsed < oldest->lastUsed))
+				oldest = &a;
+		}
+		if (!oldest)
+			return;
+		evict(*oldest);
+	}
+}
+
+void AssetManager::acquire(int h)
+{
+	std::vector<int> one(1, h);
+	acquire(one);
+}
+
+void AssetManager::release(int h)
+{
+	std::vector<int> one(1, h);
+	release(one);
+}
+
+//a set is one use, so all of it counts as used at the same time and the
+//budget is only checked once it has all changed hands
+void AssetManager::acquire(const std::vector<int> &set)
+{
+	clock++;
+	for (unsigned int i = 0; i < set.size(); i++) {
+		Asset &a = assets[set[i]];
+		a.refs++;
+		a.lastUsed = clock;
+		if (!a.resident)
+			load(a);
+	}
+	trim();
+}
+
+void AssetManager::release(const std::vector<int> &set)
+{
+	clock++;
+	for (unsigned int i = 0; i < set.size(); i++) {
+		Asset &a = assets[set[i]];
+		if (a.refs > 0)
+			a.refs--;
+		a.lastUsed = clock;
+	}
+	trim();
+}
+
+void AssetManager::report() const
+{
+	int uploads = 0;
+	long plain = 0, stored = 0;
+	for (unsigned int i = 0; i < assets.size(); i++) {
+		uploads += assets[i].uploads;
+		if (assets[i].uploads) {
+			plain += assets[i].plainBytes;
+			stored += assets[i].bytes;
+		}
+	}
+	if (uploads == 0)
+		return;
+	printf("assets: %ld kB on the card, %ld kB at most, budget %ld kB\n",
+		resident >> 10, peak >> 10, budget >> 10);
+	printf("  %-32s %-8s %8s %8s %8s %8s %8s\n", "", "format", "plain kB",
+		"kB", "sent kB", "saved kB", "uploads");
+	for (unsigned int i = 0; i < assets.size(); i++) {
+		const Asset &a = assets[i];
+		if (a.uploads == 0)
+			continue;
+		char format[16];
+		if (a.format == ASSET_PALETTE)
+			snprintf(format, sizeof format, "%d cols", a.colours);
+		else
+			snprintf(format, sizeof format, "%s", formatNames[a.format]);
+		printf("  %-32s %-8s %8ld %8ld %8ld %8ld %8d%s\n", a.image->file,
+			format, a.plainBytes >> 10, a.bytes >> 10, a.sentBytes >> 10,
+			(a.plainBytes - a.bytes) >> 10, a.uploads,
+			a.resident ? "" : "  (dropped)");
+	}
+	printf("  %ld kB saved of %ld kB, %.0f%%\n", (plain - stored) >> 10,
+		plain >> 10, plain ? 100.0 * (plain - stored) / plain : 0.0);
+}
@@ -0,0 +1,106 @@
+//Program: assets.h
+//Texture residency for Shiba Survival
+//
+//Images used to be decoded while the program started and kept on the
+//card for the whole run, the credits portraits included. Now an Image
+//only names its file. Each screen acquires the textures it draws when
+//it comes up and releases them when it goes, and a texture is decoded
+//and uploaded the first time a screen that uses it acquires it. The
+//pixels are dropped as soon as the card has them.
+//
+//A released texture stays on the card in case its screen comes back.
+//When the textures on the card add up to more than the budget, released
+//ones are dropped oldest release first until it fits again. Textures a
+//screen is using are never dropped, so a budget smaller than one screen
+//only means nothing else is kept around.
+//
+//Every texture keeps its GL name for the whole run and dropping one only
+//frees its storage, so code holding the name never has to ask again.
+//Two Images of the same file share one texture.
+//
+//Textures are stored as small as they can be without losing what is
+//drawn. An image with 256 colours or fewer is sent as one byte a pixel
+//and the card turns it back into colours through a palette; most of the
+//sprites are drawn that way. Colour keyed images are kept as RGB5_A1,
+//since the key only ever needs one bit of alpha, and images flagged
+//ASSET_16BIT as RGB5. An image that is only ever drawn in part can be
+//cropped to that part when it is loaded, and drawn with texture
+//coordinates that cover the whole of what is left.
+//
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <vector>
+#include <GL/gl.h>
+#include "Image.h"
+
+//texture memory kept on the card, SHIBA_TEXTURE_MB=n overrides it
+#define ASSET_BUDGET_MB 64
+
+enum {
+	//pixels the colour of the top left one are see-through
+	ASSET_COLORKEY = 1,
+	//five bits a channel is plenty, for big backgrounds
+	ASSET_16BIT = 2
+};
+
+//how a texture ended up stored
+enum {
+	ASSET_RGB8,
+	ASSET_RGB5,
+	ASSET_RGB5A1,
+	ASSET_PALETTE
+};
+
+struct Asset {
+	Image *image;
+	int flags;
+	GLuint texture;
+	//the part of the image kept, in texture coordinates
+	float u0, v0, u1, v1;
+	bool resident;
+	//screens using it right now
+	int refs;
+	//size on the card while resident
+	long bytes;
+	//what a plain RGB or RGBA upload of the whole image would take
+	long plainBytes;
+	//sent to the card by the last upload
+	long sentBytes;
+	int format;
+	int colours;
+	//when it was last acquired or released, for picking what to drop
+	unsigned long lastUsed;
+	int uploads;
+	double uploadSeconds;
+};
+
+class AssetManager {
+	private:
+		std::vector<Asset> assets;
+		long budget;
+		long resident;
+		long peak;
+		unsigned long clock;
+		void load(Asset &a);
+		void evict(Asset &a);
+		void trim();
+	public:
+		AssetManager();
+		void setBudget(long bytes);
+		//needs a GL context, the texture name is made here
+		int add(Image *image, int flags = 0);
+		//keep only u0..u1 by v0..v1 of the image from the next load on
+		void crop(int h, float u0, float v0, float u1, float v1);
+		GLuint texture(int h) const { return assets[h].texture; }
+		void acquire(int h);
+		void release(int h);
+		void acquire(const std::vector<int> &set);
+		void release(const std::vector<int> &set);
+		long residentBytes() const { return resident; }
+		void report() const;
+};
+
+extern AssetManager assets;
+
+#endif
@@ -0,0 +1,153 @@
+//Program: bullets.cpp
+//Projectile pool for Shiba Survival
+//
+#include <GL/glx.h>
+#include "bullets.h"
+
+BulletPool bullets;
+
+ComponentMask bulletMask()
+{
+	return maskOf<Position, Velocity, Lifetime, WrapsAround, HurtsEnemies>();
+}
+
+BulletPool::BulletPool()
+{
+	now = 0;
+	nextShot = 0;
+	boostUntil = 0;
+	setLimits(BULLET_CAPACITY, BULLET_FIRE_DELAY);
+}
+
+void BulletPool::clear()
+{
+	world.clear(bulletMask());
+	boostUntil = now;
+	capacity = baseCapacity;
+	fireDelay = baseDelay;
+}
+
+void BulletPool::setLimits(int cap, int delay)
+{
+	baseCapacity = cap;
+	baseDelay = delay;
+	if (now >= boostUntil) {
+		capacity = cap;
+		fireDelay = delay;
+	}
+}
+
+int BulletPool::count()
+{
+	return world.count(bulletMask());
+}
+
+void BulletPool::rapidFire(int ticks)
+{
+	boostUntil = now + ticks;
+	capacity = BULLET_RAPID_CAPACITY;
+	fireDelay = BULLET_RAPID_DELAY;
+}
+
+//fire(): adds a bullet unless the gun is still cooling down or full
+bool BulletPool::fire(float x, float y, float velx, float vely)
+{
+	if ((int)(now - nextShot) < 0)
+		return false;
+	if (count() >= capacity)
+		return false;
+	nextShot = now + fireDelay;
+	Entity e = world.create(bulletMask());
+	Position *p = world.get<Position>(e);
+	p->x = x;
+	p->y = y;
+	Velocity *v = world.get<Velocity>(e);
+	v->x = velx;
+	v->y = vely;
+	world.get<Lifetime>(e)->expire = now + BULLET_LIFETIME;
+	return true;
+}
+
+//update(): expire old bullets, then move and wrap the rest. A wrapped
+//bullet's last step is still pos - vel, just off the other edge.
+void BulletPool::update(unsigned int tick, float xres, float yres)
+{
+	now = tick;
+	if (boostUntil != 0 && now >= boostUntil) {
+		boostUntil = 0;
+		capacity = baseCapacity;
+		fireDelay = baseDelay;
+	}
+	//anything with a lifetime that has run out
+	world.each(maskOf<Lifetime>(), [&](Archetype &a) {
+		Lifetime *life = a.get<Lifetime>();
+		for (int i = 0; i < a.size(); i++) {
+			if ((int)(now - life[i].expire) >= 0)
+				world.destroyLater(a.ids[i]);
+		}
+	});
+	world.flush();
+	ComponentMask wraps = maskOf<WrapsAround>();
+	moveEntities(wraps);
+	wrapEntities(wraps, xres, yres);
+}
+
+//draw(): every bullet is a small cross of points, all in one call
+void BulletPool::draw()
+{
+	static const float offset[9][2] = {
+		{0, 0}, {-1, 0}, {1, 0}, {0, -1}, {0, 1},
+		{-1, -1}, {-1, 1}, {1, -1}, {1, 1}
+	};
+	int n = count();
+	if (n == 0)
+		return;
+	verts.resize(n * 9 * 2);
+	colors.resize(n * 9 * 3);
+	float *v = &verts[0];
+	float *c = &colors[0];
+	world.each(bulletMask(), [&](Archetype &a) {
+		Position *p = a.get<Position>();
+		for (int i = 0; i < a.size(); i++) {
+			for (int k = 0; k < 9; k++) {
+				*v++ = p[i].x + offset[k][0];
+				*v++ = p[i].y + offset[k][1];
+				float shade = k < 5 ? 1.0f : 0.8f;
+				*c++ = shade;
+				*c++ = shade;
+				*c++ = shade;
+			}
+		}
+	});
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, 0, &verts[0]);
+	glColorPointer(3, GL_FLOAT, 0, &colors[0]);
+	glDrawArrays(GL_POINTS, 0, n * 9);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glColor3f(1.0f, 1.0f, 1.0f);
+}
+
+void BulletPool::saveState(StateWriter &w) const
+{
+	w.put(now);
+	w.put(nextShot);
+	w.put(boostUntil);
+	w.put(capacity);
+	w.put(fireDelay);
+	w.put(baseCapacity);
+	w.put(baseDelay);
+}
+
+bool BulletPool::loadState(StateReader &r)
+{
+	r.get(now);
+	r.get(nextShot);
+	r.get(boostUntil);
+	r.get(capacity);
+	r.get(fireDelay);
+	r.get(baseCapacity);
+	r.get(baseDelay);
+	return !r.bad;
+}
@@ -0,0 +1,63 @@
+//Program: bullets.h
+//Projectile pool for Shiba Survival
+//
+//Bullets are entities with Position, Velocity and Lifetime, so the
+//shared systems move and wrap them and the enemy code finds them by
+//their HurtsEnemies tag. Lifetimes are counted in physics ticks instead
+//of timestamps, so expiring a bullet is an integer compare. The pool
+//only keeps the gun's state: how many bullets may be out at once and
+//how long between shots, both of which a power-up can raise for a
+//while.
+//
+#ifndef BULLETS_H
+#define BULLETS_H
+
+#include <vector>
+#include "ecs.h"
+#include "snapshot.h"
+
+//physics runs at 60 ticks a second
+#define BULLET_LIFETIME 150
+#define BULLET_FIRE_DELAY 6
+#define BULLET_CAPACITY 11
+#define BULLET_RAPID_DELAY 2
+#define BULLET_RAPID_CAPACITY 64
+
+//physics tick the entity is removed on
+struct Lifetime {
+	unsigned int expire;
+	Lifetime() { expire = 0; }
+};
+
+ComponentMask bulletMask();
+
+class BulletPool {
+	private:
+		std::vector<float> verts;
+		std::vector<float> colors;
+		unsigned int now;
+		unsigned int nextShot;
+		unsigned int boostUntil;
+		int capacity;
+		int fireDelay;
+		int baseCapacity;
+		int baseDelay;
+	public:
+		BulletPool();
+		void clear();
+		//normal limits, used when no power-up is active
+		void setLimits(int cap, int delay);
+		//raise the limits for the next ticks physics ticks
+		void rapidFire(int ticks);
+		bool fire(float x, float y, float velx, float vely);
+		void update(unsigned int tick, float xres, float yres);
+		void draw();
+		int count();
+		//the gun only, the bullets themselves are in the world
+		void saveState(StateWriter &w) const;
+		bool loadState(StateReader &r);
+};
+
+extern BulletPool bullets;
+
+#endif
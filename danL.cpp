@@ -8,17 +8,32 @@
 #include "amberZ.h"
 #include "josephS.h"
 #include "Image.h"
+#include "bullets.h"
+#include "timingwheel.h"
+#include "rng.h"
+#include <math.h>
 
 int xres = 1366;
 int yres = 768;
 const int shiba_size = 80;
 const float power_up_size = 20;
 const int powerUpInterval = 100;
+const int rapidFireTicks = 5 * 60;
+//chance per tick of each power-up type showing up
+const int powerUpOdds[3] = {powerUpInterval * 2, powerUpInterval * 5, powerUpInterval * 15};
+//uncollected power-ups on screen at once, more are not spawned
+const int maxPowerUps = 6;
+const int flyingShibaSpeed = 10;
+const int flyingShibaEnd = 1766;
 bool flyingShiba = false;
 int flyingShibaPos[2] = {0,500};
+unsigned int flyingShibaStart = 0;
+//the landing, moved back every time another flyer is picked up
+int flyingShibaEvent = -1;
+int powerUpEvents[3] = {-1, -1, -1};
+float spawnShibaPos[2];
 //int flyingShibaPos[2];
-GLuint powerUpTextures[3];
-vector<PowerUp> power_ups;
+GLuint powerUpTextures[4];
 Image powerUpImage[4] = {
     Image("./images/bone.png",1,1),
     Image("./images/1up.png",1,1),
@@ -48,61 +63,61 @@ void danL(int x, int y, GLuint textid)
     r.bot = y;
     r.left = x + 90;
     r.center = 0;
-    ggprint16(&r, 16, 0x00ffff00, "Dan Leinker");
+    static TextLabel name;
+    name.print(&r, 16, 0x00ffff00, "Dan Leinker");
 }
 
 
-PowerUp::PowerUp(int powerUpType, float ShibaX, float ShibaY) 
+ComponentMask powerUpMask()
 {
-    type = powerUpType;
+    return maskOf<Position, PowerUpInfo>();
+}
+
+Entity createPowerUp(int powerUpType, float ShibaX, float ShibaY) 
+{
+    Entity e = world.create(powerUpMask());
+    world.get<PowerUpInfo>(e)->type = powerUpType;
+    Position *position = world.get<Position>(e);
 
     int away = 20;
     //TODO test to make sure these values are coming out right
-    position[0] = ((int)ShibaX + (rand() % (xres - away))) % xres;
-    position[1] = ((int)ShibaY + (rand() % (yres - away))) % yres;
+    position->x = ((int)ShibaX + rngStreams[RNG_POWERUP].below(xres - away)) % xres;
+    position->y = ((int)ShibaY + rngStreams[RNG_POWERUP].below(yres - away)) % yres;
 
     #ifdef DEBUG
-    printf("\nPowerUp Constructor Type: %i %f %f",type,position[0],position[1]);
+    printf("\nPowerUp Constructor Type: %i %f %f",powerUpType,position->x,position->y);
     #endif
+    return e;
 }
 
-void PowerUp::drawPowerUp()
-{
-
-    //glBindTexture();
-    //cout << powerUpTextures[0] << endl;
-    /*     glColor3f(0.0f, 0.0f, 1.0f);
-         glBindTexture(GL_TEXTURE_2D, powerUpTextures[0]);
-         glBegin(GL_POLYGON);
-            glVertex2f(-power_up_size, power_up_size);
-            glVertex2f(power_up_size, power_up_size);
-            glVertex2f(power_up_size, -power_up_size);
-            glVertex2f(-power_up_size, -power_up_size);
-        glEnd(); */
-    //drawSprite(powerUpTextures[0],powerUpImage[0],10,10,)
-}
-
-bool PowerUp::collisionCheck(float ShibaX, float ShibaY) 
+bool powerUpCollisionCheck(const Position &position, float ShibaX, float ShibaY) 
 {
     /* bool collisionX = ShibaX + shiba_size >= position[0] &&
         position[0] + power_up_size >= ShibaX; 
     bool collisionY = ShibaY + shiba_size >= position[1] &&
         position[1] + power_up_size >= ShibaY; 
     return collisionX && collisionY; */
-    return ((ShibaX - shiba_size <= position[0] && 
-        ShibaX >= position[0] - power_up_size) &&
-        (ShibaY - shiba_size <= position[1] && 
-        ShibaY + 10 >= position[1] - power_up_size - 5));
+    return ((ShibaX - shiba_size <= position.x && 
+        ShibaX >= position.x - power_up_size) &&
+        (ShibaY - shiba_size <= position.y && 
+        ShibaY + 10 >= position.y - power_up_size - 5));
 }
 
-void PowerUp::activatePowerUp() 
+void activatePowerUp(int type) 
 {
     if (type == 0) {
         scoreObject.changeScore(100); //Changed name in my file so changed here -Joey
+        bullets.rapidFire(rapidFireTicks);
     } else if (type == 1) {
         numLivesLeft.changeLives(1);
     } else if (type == 2) {
+        //a second pickup mid flight starts the whole flight over
+        int ticks = flyingShibaEnd / flyingShibaSpeed + 1;
+        if (flyingShibaEvent != -1)
+            gameEvents.cancel(flyingShibaEvent);
+        flyingShibaEvent = gameEvents.schedule(ticks, flyingShibaLanded, NULL);
         flyingShiba = true;
+        flyingShibaStart = gameEvents.time();
         flyingShibaPos[0] = 0;
         flyingShibaPos[1] = 400;
         enemyController.cleanupEnemies();
@@ -110,49 +125,93 @@ void PowerUp::activatePowerUp()
     }
 }
 
+void flyingShibaLanded(void *)
+{
+    flyingShiba = false;
+    flyingShibaEvent = -1;
+    enemyController.cleanupEnemies();
+    flyingShibaPos[0] = 0;
+}
+
 void destroyAllPowerups() 
 {
-    power_ups.clear();
+    world.clear(powerUpMask());
 }
 
 void powerUpPhysicsCheck(float ShibaX, float ShibaY) 
 {
-    powerUpTimer(ShibaX, ShibaY);
-    powerUpCollision(ShibaX, ShibaY);
-    if (flyingShiba) {
-        flyingShibaPos[0] += 10;
-        if (flyingShibaPos[0] > 1766) {
-            flyingShiba = false;
-            enemyController.cleanupEnemies();
-            flyingShibaPos[0] = 0;
-        }
+    spawnShibaPos[0] = ShibaX;
+    spawnShibaPos[1] = ShibaY;
+    if (powerUpEvents[0] == -1) {
+        for (long type = 0; type < 3; type++)
+            schedulePowerUp(type);
     }
+    gameEvents.tick();
+    powerUpCollision(ShibaX, ShibaY);
 }
 
-void powerUpTimer(float ShibaX, float ShibaY) 
+//Rolling a 1 in n chance every tick means the wait until the next
+//spawn is geometric, so sample that wait once and schedule it instead
+//of rolling every tick.
+void schedulePowerUp(long type)
 {
-    //See if we should spawn some powerups
-    if ((rand() % (powerUpInterval * 2)) == 1) {
-        spawnPowerUp(1,0,ShibaX,ShibaY);
-    }
-    if ((rand() % (powerUpInterval * 5)) == 1) {
-        spawnPowerUp(1,1,ShibaX,ShibaY);
-    }
-    if ((rand() % (powerUpInterval * 15)) == 1) {
-        spawnPowerUp(1,2,ShibaX,ShibaY);
-    }
+    double p = 1.0 / powerUpOdds[type];
+    double u = 1.0 - rngStreams[RNG_POWERUP].unit();
+    unsigned int wait = 1 + (unsigned int)(log(u) / log(1.0 - p));
+    powerUpEvents[type] = gameEvents.schedule(wait, powerUpTimer, (void *)type);
+}
+
+void powerUpTimer(void *ctx)
+{
+    long type = (long)ctx;
+    if (world.count(powerUpMask()) < maxPowerUps)
+        spawnPowerUp(1, type, spawnShibaPos[0], spawnShibaPos[1]);
+    schedulePowerUp(type);
     #ifdef DEBUG
-    //printf("\nPowerUpTimer function %i",mil);
+    //printf("\nPowerUpTimer function %li",type);
     #endif
 }
 
+//resetPowerUps(): game over, drop everything that was scheduled
+void resetPowerUps()
+{
+    gameEvents.clear();
+    for (int i = 0; i < 3; i++)
+        powerUpEvents[i] = -1;
+    world.clear(powerUpMask());
+    flyingShiba = false;
+    flyingShibaEvent = -1;
+    flyingShibaPos[0] = 0;
+}
+
+void savePowerUps(StateWriter &w)
+{
+    w.put(flyingShiba);
+    w.put(flyingShibaPos);
+    w.put(flyingShibaStart);
+    w.put(flyingShibaEvent);
+    w.put(powerUpEvents);
+    w.put(spawnShibaPos);
+}
+
+bool loadPowerUps(StateReader &r)
+{
+    r.get(flyingShiba);
+    r.get(flyingShibaPos);
+    r.get(flyingShibaStart);
+    r.get(flyingShibaEvent);
+    r.get(powerUpEvents);
+    r.get(spawnShibaPos);
+    return !r.bad;
+}
+
 void spawnPowerUp(int num, int powerUpType, float shibaX, float shibaY) 
 {
     #ifdef DEBUG
     printf("\nspawnPowerup function");
     #endif
 	for(int i = 0; i < num; i++)
-		power_ups.push_back(PowerUp(powerUpType, shibaX, shibaY));
+		createPowerUp(powerUpType, shibaX, shibaY);
 }
 
 void powerUpCollision(float ShibaX,float ShibaY) 
@@ -163,44 +222,48 @@ void powerUpCollision(float ShibaX,float ShibaY)
     // If it collides
     // -Apply powerup
     // -Destroy powerup
-    for (auto it=power_ups.begin(); it != power_ups.end();) {
-        //printf("\n%f",it->position[0]);
-        if (it->collisionCheck(ShibaX,ShibaY)) {
-            it->activatePowerUp();
-            it = power_ups.erase(it);
-        } else {
-            ++it;
+    static vector<int> collected;
+    collected.clear();
+    world.each(powerUpMask(), [&](Archetype &a) {
+        Position *p = a.get<Position>();
+        PowerUpInfo *info = a.get<PowerUpInfo>();
+        for (int i = 0; i < a.size(); i++) {
+            if (powerUpCollisionCheck(p[i], ShibaX, ShibaY)) {
+                collected.push_back(info[i].type);
+                world.destroyLater(a.ids[i]);
+            }
         }
-    }
+    });
+    world.flush();
+    for (unsigned int i = 0; i < collected.size(); i++)
+        activatePowerUp(collected[i]);
 }
 
 void renderPowerUps() 
 {
     Image* test = &powerUpImage[0];
-	for(unsigned int i = 0; i < power_ups.size(); i++) {
-        //cout << "About to draw sprite" << endl;
-        //cout << "Power up texture: " << powerUpTextures[0] << endl;
-        //cout << "Power up image:   " << powerUpImage << endl;
-        float powerUpX = power_ups[i].position[0];
-        float powerUpY = power_ups[i].position[1];
-        if (power_ups[i].type == 0) {
-            drawSprite(powerUpTextures[power_ups[i].type],
-                *test,26,12,powerUpX,powerUpY);
-        } else if (power_ups[i].type == 1) {
-            drawSprite(powerUpTextures[power_ups[i].type],
-                *test,25,25,powerUpX,powerUpY);
-        } else if (power_ups[i].type == 2) {
-            drawSprite(powerUpTextures[power_ups[i].type],
-                *test,40,40,powerUpX,powerUpY);
+    world.each(powerUpMask(), [&](Archetype &a) {
+        Position *p = a.get<Position>();
+        PowerUpInfo *info = a.get<PowerUpInfo>();
+        for (int i = 0; i < a.size(); i++) {
+            float powerUpX = p[i].x;
+            float powerUpY = p[i].y;
+            if (info[i].type == 0) {
+                drawSprite(powerUpTextures[info[i].type],
+                    *test,26,12,powerUpX,powerUpY);
+            } else if (info[i].type == 1) {
+                drawSprite(powerUpTextures[info[i].type],
+                    *test,25,25,powerUpX,powerUpY);
+            } else if (info[i].type == 2) {
+                drawSprite(powerUpTextures[info[i].type],
+                    *test,40,40,powerUpX,powerUpY);
+            }
         }
-	    //glPushMatrix();
-		//glTranslated(power_ups[i].position[0], power_ups[i].position[1], 0);
-		//power_ups[i].drawPowerUp();
-	    //glPopMatrix();
-	}
+    });
     //cout << "Render powerups Flying shiba is: " << flyingShiba << " x: " 
     //cout << flyingShibaPos[0] << " y: " << flyingShibaPos[1] << endl;
     if (flyingShiba) {
+        flyingShibaPos[0] = (gameEvents.time() - flyingShibaStart) * flyingShibaSpeed;
         drawSprite(powerUpTextures[3],*test,400,400,
             flyingShibaPos[0],flyingShibaPos[1]);
     }
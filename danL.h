@@ -3,7 +3,9 @@
 
 #include <GL/glx.h>
 #include "fonts.h"
+#include "text.h"
 #include "Image.h"
+#include "ecs.h"
 #include <stdlib.h>
 #include <vector>
 #include <stdio.h>
@@ -11,21 +13,25 @@
 using namespace std;
 
 
-class PowerUp{
-    public:
-        float position[2];
-        int type;
-        void drawPowerUp();
-        void shibaCollision(int);
-        bool collisionCheck(float,float);
-        void activatePowerUp();
-        PowerUp(int, float,float);
+// 0 bone, 1 extra life, 2 flying shiba
+struct PowerUpInfo {
+    int type;
+    PowerUpInfo() { type = 0; }
 };
 
-extern std::vector<PowerUp> power_ups;
+ComponentMask powerUpMask();
+Entity createPowerUp(int, float, float);
+bool powerUpCollisionCheck(const Position &, float, float);
+void activatePowerUp(int);
 
 void powerUpPhysicsCheck(float, float);
-void powerUpTimer(float, float);
+void schedulePowerUp(long);
+void powerUpTimer(void *);
+void flyingShibaLanded(void *);
+void resetPowerUps();
+// flying shiba and the power-up timers, the power-ups are in the world
+void savePowerUps(StateWriter &);
+bool loadPowerUps(StateReader &);
 void spawnPowerUp(int, int, float, float);
 void destroyPowerUp(int);
 void renderPowerUps();
@@ -34,7 +40,7 @@ bool isShibaFlying();
 void loadPowerUpImages();
 unsigned char buildAlpha(Image);
 extern void danL(float, float, GLuint);
-extern GLuint powerUpTextures[3];
+extern GLuint powerUpTextures[4];
 extern Image powerUpImage[4];
 extern bool flyingShiba;
 
@@ -0,0 +1,357 @@
+//Program: ecs.cpp
+//Entity component system for Shiba Survival
+//
+#include "ecs.h"
+#include "jobs.h"
+
+World world;
+
+#define ENTITY_INDEX(e) ((e) & 0xfffff)
+#define ENTITY_GENERATION(e) ((e) >> 20)
+
+struct ComponentInfo {
+	int size;
+	bool tag;
+	const char *name;
+	std::vector<unsigned char> prototype;
+};
+
+static std::vector<ComponentInfo> &components()
+{
+	static std::vector<ComponentInfo> list;
+	return list;
+}
+
+//ecsRegister(): called once per component type by componentId<T>()
+int ecsRegister(int size, bool tag, const void *prototype, const char *name)
+{
+	std::vector<ComponentInfo> &list = components();
+	ComponentInfo c;
+	c.size = tag ? 0 : size;
+	c.tag = tag;
+	c.name = name;
+	c.prototype.assign((const unsigned char *)prototype,
+		(const unsigned char *)prototype + c.size);
+	list.push_back(c);
+	return list.size() - 1;
+}
+
+Archetype::Archetype(ComponentMask m)
+{
+	mask = m;
+}
+
+void *Archetype::column(int comp)
+{
+	if (!(mask & (1u << comp)) || columns[comp].empty())
+		return 0;
+	return &columns[comp][0];
+}
+
+int Archetype::addRow(Entity e)
+{
+	std::vector<ComponentInfo> &list = components();
+	for (unsigned int c = 0; c < list.size(); c++) {
+		if (!(mask & (1u << c)) || list[c].tag)
+			continue;
+		columns[c].insert(columns[c].end(), list[c].prototype.begin(),
+			list[c].prototype.end());
+	}
+	ids.push_back(e);
+	return ids.size() - 1;
+}
+
+Entity Archetype::removeRow(int row)
+{
+	std::vector<ComponentInfo> &list = components();
+	int last = ids.size() - 1;
+	for (unsigned int c = 0; c < list.size(); c++) {
+		if (!(mask & (1u << c)) || list[c].tag)
+			continue;
+		int size = list[c].size;
+		if (row != last)
+			memcpy(&columns[c][row * size], &columns[c][last * size], size);
+		columns[c].resize(last * size);
+	}
+	Entity moved = ids[last];
+	ids[row] = moved;
+	ids.pop_back();
+	return row == last ? ECS_NO_ENTITY : moved;
+}
+
+//reserve(): grows by at least double, so callers that reserve a few
+//more rows every tick still only reallocate now and then
+void Archetype::reserve(int rows)
+{
+	if (rows <= (int)ids.capacity())
+		return;
+	if (rows < 2 * (int)ids.capacity())
+		rows = 2 * ids.capacity();
+	std::vector<ComponentInfo> &list = components();
+	for (unsigned int c = 0; c < list.size(); c++) {
+		if ((mask & (1u << c)) && !list[c].tag)
+			columns[c].reserve(rows * list[c].size);
+	}
+	ids.reserve(rows);
+}
+
+World::World()
+{
+}
+
+int World::findArchetype(ComponentMask m)
+{
+	for (unsigned int i = 0; i < archetypes.size(); i++) {
+		if (archetypes[i].mask == m)
+			return i;
+	}
+	archetypes.push_back(Archetype(m));
+	return archetypes.size() - 1;
+}
+
+Entity World::create(ComponentMask m)
+{
+	int index;
+	if (!freeIds.empty()) {
+		index = freeIds.back();
+		freeIds.pop_back();
+	} else {
+		index = records.size();
+		EntityRecord r;
+		r.generation = 0;
+		records.push_back(r);
+	}
+	EntityRecord &r = records[index];
+	Entity e = (r.generation << 20) | index;
+	r.archetype = findArchetype(m);
+	r.row = archetypes[r.archetype].addRow(e);
+	return e;
+}
+
+bool World::alive(Entity e) const
+{
+	unsigned int index = ENTITY_INDEX(e);
+	return index < records.size() && records[index].row >= 0 &&
+		records[index].generation == ENTITY_GENERATION(e);
+}
+
+void World::destroy(Entity e)
+{
+	if (!alive(e))
+		return;
+	EntityRecord &r = records[ENTITY_INDEX(e)];
+	Entity moved = archetypes[r.archetype].removeRow(r.row);
+	if (moved != ECS_NO_ENTITY)
+		records[ENTITY_INDEX(moved)].row = r.row;
+	r.row = -1;
+	r.generation = (r.generation + 1) & 0xfff;
+	freeIds.push_back(ENTITY_INDEX(e));
+}
+
+void World::destroyLater(Entity e)
+{
+	doomed.push_back(e);
+}
+
+//flush(): destroys in the order they were queued, so the result is the
+//same however the systems that queued them were split across threads
+void World::flush()
+{
+	for (unsigned int i = 0; i < doomed.size(); i++)
+		destroy(doomed[i]);
+	doomed.clear();
+}
+
+void World::clear(ComponentMask m)
+{
+	for (unsigned int i = 0; i < archetypes.size(); i++) {
+		Archetype &a = archetypes[i];
+		if (!a.has(m))
+			continue;
+		while (a.size() > 0)
+			destroy(a.ids[a.size() - 1]);
+	}
+}
+
+int World::count(ComponentMask m) const
+{
+	int n = 0;
+	for (unsigned int i = 0; i < archetypes.size(); i++) {
+		if (archetypes[i].has(m))
+			n += archetypes[i].size();
+	}
+	return n;
+}
+
+void World::reserve(ComponentMask m, int n)
+{
+	Archetype &a = archetypes[findArchetype(m)];
+	a.reserve(a.size() + n);
+}
+
+//saveState(): the component table, then every archetype column as it is
+void World::saveState(StateWriter &w) const
+{
+	std::vector<ComponentInfo> &list = components();
+	w.put((int)list.size());
+	for (unsigned int c = 0; c < list.size(); c++) {
+		int len = strlen(list[c].name);
+		w.put(list[c].size);
+		w.put(len);
+		w.bytes(list[c].name, len);
+	}
+	w.putVector(records);
+	w.putVector(freeIds);
+	w.put((int)archetypes.size());
+	for (unsigned int i = 0; i < archetypes.size(); i++) {
+		const Archetype &a = archetypes[i];
+		w.put(a.mask);
+		w.putVector(a.ids);
+		for (unsigned int c = 0; c < list.size(); c++) {
+			if ((a.mask & (1u << c)) && !list[c].tag)
+				w.putVector(a.columns[c]);
+		}
+	}
+}
+
+bool World::loadState(StateReader &r)
+{
+	std::vector<ComponentInfo> &list = components();
+	int saved = 0;
+	r.get(saved);
+	if (saved < 0 || saved > ECS_MAX_COMPONENTS)
+		return false;
+	//component id in the snapshot to id in this process
+	int remap[ECS_MAX_COMPONENTS];
+	for (int c = 0; c < saved; c++) {
+		int size = 0, len = 0;
+		char name[256];
+		r.get(size);
+		r.get(len);
+		if (r.bad || len < 0 || len >= (int)sizeof name)
+			return false;
+		r.bytes(name, len);
+		name[len] = '\0';
+		remap[c] = -1;
+		for (unsigned int k = 0; k < list.size(); k++) {
+			if (strcmp(list[k].name, name) == 0 && list[k].size == size)
+				remap[c] = k;
+		}
+	}
+	std::vector<EntityRecord> newRecords;
+	std::vector<int> newFreeIds;
+	r.getVector(newRecords);
+	r.getVector(newFreeIds);
+	int count = 0;
+	r.get(count);
+	if (r.bad || count < 0)
+		return false;
+	std::vector<Archetype> loaded(count);
+	for (int i = 0; i < count && !r.bad; i++) {
+		Archetype &a = loaded[i];
+		ComponentMask savedMask = 0;
+		r.get(savedMask);
+		r.getVector(a.ids);
+		for (int c = 0; c < saved; c++) {
+			if (!(savedMask & (1u << c)))
+				continue;
+			if (remap[c] < 0)
+				return false;
+			int k = remap[c];
+			a.mask |= 1u << k;
+			if (!list[k].tag) {
+				r.getVector(a.columns[k]);
+				if (a.columns[k].size() != a.ids.size() * list[k].size)
+					return false;
+			}
+		}
+	}
+	if (r.bad)
+		return false;
+	archetypes.swap(loaded);
+	records.swap(newRecords);
+	freeIds.swap(newFreeIds);
+	doomed.clear();
+	return true;
+}
+
+//=============================================================
+// Shared systems
+//=============================================================
+
+void moveEntities(ComponentMask m)
+{
+	world.each(m | maskOf<Position, Velocity>(), [](Archetype &a) {
+		Position *p = a.get<Position>();
+		Velocity *v = a.get<Velocity>();
+		auto step = [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				p[i].x += v[i].x;
+				p[i].y += v[i].y;
+			}
+		};
+		jobSystem.parallelFor(a.size(), 512, step);
+	});
+}
+
+//off one edge and back on the opposite one
+void wrapEntities(ComponentMask m, float xres, float yres)
+{
+	world.each(m | maskOf<Position, WrapsAround>(), [&](Archetype &a) {
+		Position *p = a.get<Position>();
+		for (int i = 0; i < a.size(); i++) {
+			if (p[i].x < 0.0f)
+				p[i].x += xres;
+			else if (p[i].x > xres)
+				p[i].x -= xres;
+			else if (p[i].y < 0.0f)
+				p[i].y += yres;
+			else if (p[i].y > yres)
+				p[i].y -= yres;
+		}
+	});
+}
+
+//kept fully on screen, heading back the way it came
+void bounceEntities(ComponentMask m, float xres, float yres)
+{
+	world.each(m | maskOf<Position, Velocity, Size, BouncesOffEdges>(), [&](Archetype &a) {
+		Position *p = a.get<Position>();
+		Velocity *v = a.get<Velocity>();
+		Size *s = a.get<Size>();
+		auto bounce = [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				if ((p[i].x - s[i].half) <= 0) {
+					p[i].x = s[i].half;
+					v[i].x *= -1;
+				}
+				if ((p[i].x + s[i].half) >= xres) {
+					p[i].x = xres - s[i].half;
+					v[i].x *= -1;
+				}
+				if ((p[i].y - s[i].half) <= 0) {
+					p[i].y = s[i].half;
+					v[i].y *= -1;
+				}
+				if ((p[i].y + s[i].half) >= yres) {
+					p[i].y = yres - s[i].half;
+					v[i].y *= -1;
+				}
+			}
+		};
+		jobSystem.parallelFor(a.size(), 512, bounce);
+	});
+}
+
+//gone once its centre leaves the screen
+void cullEntities(ComponentMask m, float xres, float yres)
+{
+	world.each(m | maskOf<Position, LeavesScreen>(), [&](Archetype &a) {
+		Position *p = a.get<Position>();
+		for (int i = 0; i < a.size(); i++) {
+			if (p[i].x < 0 || p[i].x > xres || p[i].y < 0 || p[i].y > yres)
+				world.destroyLater(a.ids[i]);
+		}
+	});
+	world.flush();
+}
@@ -0,0 +1,160 @@
+//Program: ecs.h
+//Entity component system for Shiba Survival
+//
+//An entity is just an id. Its data lives in components, small plain
+//structs declared by whichever file owns them. Entities with the same
+//set of components share an archetype, which keeps one packed array
+//per component, so a system that only needs positions and velocities
+//walks just those two arrays for every kind of entity that has them.
+//Empty structs work as tags: they mark an archetype but store nothing.
+//
+//Components are copied around as raw bytes, so they have to be
+//trivially copyable. New rows start as a copy of a default constructed
+//component. The same goes for snapshots, which save every column as it
+//is and match components up again by type name, since the ids depend
+//on the order the types were first used in.
+//
+#ifndef ECS_H
+#define ECS_H
+
+#include <vector>
+#include <cstring>
+#include <type_traits>
+#include <typeinfo>
+#include "snapshot.h"
+
+#define ECS_MAX_COMPONENTS 32
+
+typedef unsigned int Entity;
+typedef unsigned int ComponentMask;
+
+#define ECS_NO_ENTITY 0xffffffffu
+
+//the components every moving thing uses
+struct Position {
+	float x, y;
+	Position() { x = y = 0.0f; }
+};
+
+struct Velocity {
+	float x, y;
+	Velocity() { x = y = 0.0f; }
+};
+
+//half the width of the square the entity takes up
+struct Size {
+	float half;
+	Size() { half = 0.0f; }
+};
+
+//how an entity treats the edges of the screen
+struct WrapsAround {};
+struct BouncesOffEdges {};
+struct LeavesScreen {};
+
+//what touching it does
+struct HurtsShiba {};
+struct HurtsEnemies {};
+
+int ecsRegister(int size, bool tag, const void *prototype, const char *name);
+
+template <class T>
+int componentId()
+{
+	static_assert(std::is_trivially_copyable<T>::value,
+		"components are copied as bytes");
+	static const T prototype = T();
+	static int id = ecsRegister(sizeof(T), std::is_empty<T>::value, &prototype,
+		typeid(T).name());
+	return id;
+}
+
+template <class T>
+ComponentMask maskOf()
+{
+	return 1u << componentId<T>();
+}
+
+template <class T, class U, class... Rest>
+ComponentMask maskOf()
+{
+	return maskOf<T>() | maskOf<U, Rest...>();
+}
+
+class Archetype {
+	friend class World;
+	private:
+		std::vector<unsigned char> columns[ECS_MAX_COMPONENTS];
+	public:
+		ComponentMask mask;
+		std::vector<Entity> ids;
+		Archetype(ComponentMask m = 0);
+		int size() const { return ids.size(); }
+		bool has(ComponentMask m) const { return (mask & m) == m; }
+		int addRow(Entity e);
+		//moves the last row into row, returns the entity that moved
+		Entity removeRow(int row);
+		void reserve(int rows);
+		void *column(int comp);
+		template <class T>
+		T *get() { return (T *)column(componentId<T>()); }
+};
+
+struct EntityRecord {
+	int archetype;
+	int row;
+	unsigned int generation;
+};
+
+class World {
+	private:
+		std::vector<Archetype> archetypes;
+		std::vector<EntityRecord> records;
+		std::vector<int> freeIds;
+		std::vector<Entity> doomed;
+		int findArchetype(ComponentMask m);
+	public:
+		World();
+		Entity create(ComponentMask m);
+		bool alive(Entity e) const;
+		void destroy(Entity e);
+		//queue a destroy for flush(), so systems can keep iterating
+		void destroyLater(Entity e);
+		void flush();
+		//destroy every entity that has all of m
+		void clear(ComponentMask m);
+		int count(ComponentMask m) const;
+		//ids ever handed out, alive or waiting to be reused
+		int slots() const { return records.size(); }
+		//rows ready for the next n entities with exactly mask m
+		void reserve(ComponentMask m, int n);
+		void saveState(StateWriter &w) const;
+		//every component in the snapshot has to be registered already
+		bool loadState(StateReader &r);
+		template <class T>
+		T *get(Entity e) {
+			if (!alive(e))
+				return 0;
+			const EntityRecord &r = records[e & 0xfffff];
+			T *col = archetypes[r.archetype].get<T>();
+			return col ? col + r.row : 0;
+		}
+		//fn(Archetype &) for every non-empty archetype that has all of m
+		template <class F>
+		void each(ComponentMask m, F fn) {
+			for (unsigned int i = 0; i < archetypes.size(); i++) {
+				if (archetypes[i].has(m) && archetypes[i].size() > 0)
+					fn(archetypes[i]);
+			}
+		}
+};
+
+extern World world;
+
+//systems shared by every entity type, m picks which entities take part
+void moveEntities(ComponentMask m);
+void wrapEntities(ComponentMask m, float xres, float yres);
+void bounceEntities(ComponentMask m, float xres, float yres);
+void cullEntities(ComponentMask m, float xres, float yres);
+
+#endif
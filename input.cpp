@@ -0,0 +1,151 @@
+//Program: input.cpp
+//Keyboard input thread for Shiba Survival
+//
+#include <stdio.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <X11/XKBlib.h>
+#include "input.h"
+
+InputThread inputThread;
+KeyState keyState;
+
+KeyQueue::KeyQueue()
+{
+	head = 0;
+	tail = 0;
+}
+
+bool KeyQueue::push(const KeyEvent &e)
+{
+	unsigned t = tail.load(std::memory_order_relaxed);
+	if (t - head.load(std::memory_order_acquire) >= SIZE)
+		return false;
+	ring[t % SIZE] = e;
+	tail.store(t + 1, std::memory_order_release);
+	return true;
+}
+
+bool KeyQueue::peek(KeyEvent &e)
+{
+	unsigned h = head.load(std::memory_order_relaxed);
+	if (h == tail.load(std::memory_order_acquire))
+		return false;
+	e = ring[h % SIZE];
+	return true;
+}
+
+void KeyQueue::pop()
+{
+	head.store(head.load(std::memory_order_relaxed) + 1,
+		std::memory_order_release);
+}
+
+bool KeyQueue::empty()
+{
+	return head.load(std::memory_order_relaxed) ==
+		tail.load(std::memory_order_acquire);
+}
+
+void KeyState::clearEdges()
+{
+	pressed.reset();
+	released.reset();
+}
+
+void KeyState::apply(const KeyEvent &e)
+{
+	if (e.press) {
+		down[e.key] = 1;
+		pressed[e.key] = 1;
+	} else {
+		down[e.key] = 0;
+		released[e.key] = 1;
+	}
+}
+
+void KeyState::reset()
+{
+	down.reset();
+	clearEdges();
+}
+
+InputThread::InputThread()
+{
+	dpy = NULL;
+	stopFd = wakeFd = -1;
+	dropped = 0;
+}
+
+//start(): open our own connection and listen for keys on the game window
+bool InputThread::start(Window win)
+{
+	dpy = XOpenDisplay(NULL);
+	if (dpy == NULL) {
+		printf("input: cannot connect to X server\n");
+		return false;
+	}
+	//held keys repeat presses only, without fake releases in between
+	XkbSetDetectableAutoRepeat(dpy, True, NULL);
+	XSelectInput(dpy, win, KeyPressMask | KeyReleaseMask);
+	XFlush(dpy);
+	stopFd = eventfd(0, EFD_NONBLOCK);
+	wakeFd = eventfd(0, EFD_NONBLOCK);
+	worker = std::thread(&InputThread::run, this);
+	return true;
+}
+
+void InputThread::run()
+{
+	struct pollfd fds[2];
+	fds[0].fd = ConnectionNumber(dpy);
+	fds[0].events = POLLIN;
+	fds[1].fd = stopFd;
+	fds[1].events = POLLIN;
+	while (1) {
+		while (XPending(dpy)) {
+			XEvent e;
+			XNextEvent(dpy, &e);
+			if (e.type != KeyPress && e.type != KeyRelease)
+				continue;
+			KeyEvent k;
+			clock_gettime(CLOCK_REALTIME, &k.time);
+			k.key = XLookupKeysym(&e.xkey, 0) & 0x0000ffff;
+			k.press = (e.type == KeyPress);
+			if (!queue.push(k)) {
+				dropped++;
+				continue;
+			}
+			uint64_t one = 1;
+			ssize_t ret = write(wakeFd, &one, sizeof one);
+			(void)ret;
+		}
+		if (poll(fds, 2, -1) < 0)
+			continue;
+		if (fds[1].revents & POLLIN)
+			break;
+	}
+}
+
+void InputThread::stop()
+{
+	if (!worker.joinable())
+		return;
+	uint64_t one = 1;
+	ssize_t ret = write(stopFd, &one, sizeof one);
+	(void)ret;
+	worker.join();
+	XCloseDisplay(dpy);
+	close(stopFd);
+	close(wakeFd);
+	dpy = NULL;
+}
+
+//clearWake(): reset the wake counter once the main loop is awake
+void InputThread::clearWake()
+{
+	uint64_t n;
+	ssize_t ret = read(wakeFd, &n, sizeof n);
+	(void)ret;
+}
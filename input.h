@@ -0,0 +1,76 @@
+//Program: input.h
+//Keyboard input thread for Shiba Survival
+//
+//A second X connection on its own thread blocks waiting for key events,
+//timestamps each one as it arrives and hands it to the game loop through
+//a single producer, single consumer queue. The game drains the queue one
+//physics tick at a time, so presses are applied at the tick they happened
+//in and a press and release inside the same frame is still seen.
+//
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <atomic>
+#include <bitset>
+#include <thread>
+#include <time.h>
+#include <X11/Xlib.h>
+
+struct KeyEvent {
+	struct timespec time;
+	unsigned short key;
+	bool press;
+};
+
+//lock free ring buffer, one thread pushes and one thread pops
+class KeyQueue {
+	private:
+		static const unsigned SIZE = 1024;
+		KeyEvent ring[SIZE];
+		std::atomic<unsigned> head;
+		std::atomic<unsigned> tail;
+	public:
+		KeyQueue();
+		bool push(const KeyEvent &);
+		bool peek(KeyEvent &);
+		void pop();
+		bool empty();
+};
+
+class KeyState {
+	private:
+		std::bitset<65536> down;
+		std::bitset<65536> pressed;
+		std::bitset<65536> released;
+	public:
+		void clearEdges();
+		void apply(const KeyEvent &);
+		void reset();
+		//held now, or tapped at some point during this tick
+		bool isDown(int key) { return down[key] || pressed[key]; }
+		bool wasPressed(int key) { return pressed[key]; }
+		bool wasReleased(int key) { return released[key]; }
+};
+
+class InputThread {
+	private:
+		Display *dpy;
+		int stopFd;
+		int wakeFd;
+		std::thread worker;
+		std::atomic<unsigned> dropped;
+		void run();
+	public:
+		KeyQueue queue;
+		InputThread();
+		bool start(Window win);
+		void stop();
+		int getWakeFd() { return wakeFd; }
+		void clearWake();
+		unsigned getDropped() { return dropped; }
+};
+
+extern InputThread inputThread;
+extern KeyState keyState;
+
+#endif
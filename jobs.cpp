@@ -0,0 +1,157 @@
+//Program: jobs.cpp
+//Work stealing job system for Shiba Survival
+//
+#include <algorithm>
+#include "jobs.h"
+
+JobSystem jobSystem;
+
+JobDeque::JobDeque()
+{
+	head = tail = 0;
+}
+
+bool JobDeque::push(const Job &j)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (tail - head >= JOBS_DEQUE_SIZE)
+		return false;
+	ring[tail % JOBS_DEQUE_SIZE] = j;
+	tail++;
+	return true;
+}
+
+//the owner takes the newest chunk
+bool JobDeque::popBack(Job &j)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (tail == head)
+		return false;
+	tail--;
+	j = ring[tail % JOBS_DEQUE_SIZE];
+	return true;
+}
+
+//thieves take the oldest chunk
+bool JobDeque::stealFront(Job &j)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (tail == head)
+		return false;
+	j = ring[head % JOBS_DEQUE_SIZE];
+	head++;
+	return true;
+}
+
+JobSystem::JobSystem()
+{
+	nworkers = 1;
+	pending = 0;
+	quit = false;
+	generation = 0;
+}
+
+JobSystem::~JobSystem()
+{
+	stop();
+}
+
+//start(): spin up n workers including the caller, 0 means one per core
+void JobSystem::start(int n)
+{
+	stop();
+	if (n <= 0)
+		n = std::thread::hardware_concurrency();
+	if (n < 1)
+		n = 1;
+	if (n > JOBS_MAX_WORKERS)
+		n = JOBS_MAX_WORKERS;
+	nworkers = n;
+	quit = false;
+	for (int i = 1; i < nworkers; i++)
+		threads.push_back(std::thread(&JobSystem::workerLoop, this, i));
+}
+
+void JobSystem::stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		quit = true;
+		generation++;
+	}
+	wake.notify_all();
+	for (unsigned int i = 0; i < threads.size(); i++)
+		threads[i].join();
+	threads.clear();
+	nworkers = 1;
+}
+
+bool JobSystem::findJob(int self, Job &j)
+{
+	if (deques[self].popBack(j))
+		return true;
+	for (int i = 1; i < nworkers; i++) {
+		if (deques[(self + i) % nworkers].stealFront(j))
+			return true;
+	}
+	return false;
+}
+
+void JobSystem::workerLoop(int self)
+{
+	unsigned seen = 0;
+	while (1) {
+		Job j;
+		if (findJob(self, j)) {
+			j.fn(j.ctx, j.begin, j.end);
+			pending--;
+			continue;
+		}
+		std::unique_lock<std::mutex> guard(sleepLock);
+		wake.wait(guard, [&] { return quit || generation != seen; });
+		if (quit)
+			return;
+		seen = generation;
+	}
+}
+
+void JobSystem::run(int count, int grain, void (*fn)(void *, int, int), void *ctx)
+{
+	if (count <= 0)
+		return;
+	if (grain < 1)
+		grain = 1;
+	if (nworkers == 1 || count <= grain) {
+		fn(ctx, 0, count);
+		return;
+	}
+	//a few chunks per worker leaves room to even out by stealing
+	int nchunks = (count + grain - 1) / grain;
+	if (nchunks > nworkers * 4)
+		nchunks = nworkers * 4;
+	int size = (count + nchunks - 1) / nchunks;
+	nchunks = (count + size - 1) / size;
+	pending += nchunks;
+	for (int c = 0; c < nchunks; c++) {
+		Job j = { fn, ctx, c * size, std::min(count, (c + 1) * size) };
+		if (!deques[c % nworkers].push(j)) {
+			fn(ctx, j.begin, j.end);
+			pending--;
+		}
+	}
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		generation++;
+	}
+	wake.notify_all();
+	//the caller is worker 0 and helps until everything has finished
+	Job j;
+	while (pending > 0) {
+		if (findJob(0, j)) {
+			j.fn(j.ctx, j.begin, j.end);
+			pending--;
+		} else {
+			std::this_thread::yield();
+		}
+	}
+}
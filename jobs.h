@@ -0,0 +1,75 @@
+//Program: jobs.h
+//Work stealing job system for Shiba Survival
+//
+//parallelFor() cuts a range into chunks and deals them out to one deque
+//per worker thread. A worker runs its own chunks newest first and, once
+//its deque is empty, steals the oldest chunk from another worker. The
+//calling thread works as worker 0 and returns when every chunk is done.
+//Each chunk should only write to its own slice of the output, so the
+//result is the same no matter which thread ran what.
+//
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define JOBS_MAX_WORKERS 64
+#define JOBS_DEQUE_SIZE 256
+
+struct Job {
+	void (*fn)(void *, int, int);
+	void *ctx;
+	int begin;
+	int end;
+};
+
+class JobDeque {
+	private:
+		Job ring[JOBS_DEQUE_SIZE];
+		int head;
+		int tail;
+		std::mutex lock;
+	public:
+		JobDeque();
+		bool push(const Job &);
+		bool popBack(Job &);
+		bool stealFront(Job &);
+};
+
+class JobSystem {
+	private:
+		int nworkers;
+		JobDeque deques[JOBS_MAX_WORKERS];
+		std::vector<std::thread> threads;
+		std::atomic<int> pending;
+		std::atomic<bool> quit;
+		std::mutex sleepLock;
+		std::condition_variable wake;
+		unsigned generation;
+		bool findJob(int self, Job &);
+		void workerLoop(int self);
+		void run(int count, int grain, void (*fn)(void *, int, int), void *ctx);
+		template <class F>
+		static void invoke(void *ctx, int begin, int end) {
+			(*(F *)ctx)(begin, end);
+		}
+	public:
+		JobSystem();
+		~JobSystem();
+		void start(int n);
+		void stop();
+		int workerCount() { return nworkers; }
+		//fn(begin, end) is called for chunks of at least grain items
+		template <class F>
+		void parallelFor(int count, int grain, F &fn) {
+			run(count, grain, &invoke<F>, &fn);
+		}
+};
+
+extern JobSystem jobSystem;
+
+#endif
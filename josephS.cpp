@@ -4,6 +4,11 @@
 //Last Worked on: 5/9/2019
 
 #include "josephS.h"
+#include "jobs.h"
+#include "rng.h"
+#include "spawn.h"
+#include "waves.h"
+#include "arena.h"
 #include <iostream>
 
 JoeyGlobal *JoeyGlobal::instance = 0;
@@ -26,247 +31,142 @@ Image enemyImages[numEnemyImages] = {
 		Image("./images/heManHey.png", 1, 1),
 		Image("./images/Doctor_Left.png", 1, 4)};
 
-Enemy::Enemy()
+EnemyInfo::EnemyInfo()
 {
-	velocity[0] = 0;
-	velocity[1] = 0;
-	sideLength = float(rand() % 60 + 15);
-	if (sideLength > 50) {
-		splitter = true;
-	}
 	health = 100;
 	speed = .01;
-
-	if (sideLength <= 30) {
-		imageIndex = 0;
-	} else if (sideLength > 30 && sideLength <= 40) {
-		imageIndex = 1;
-	} else if (sideLength > 40 && sideLength <= 50) {
-		imageIndex = 4;
-	} else {
-		imageIndex = 2;
-	}
-
-	textureUsed = JSglobalVars->textureArray[imageIndex];
-	imageUsed = &enemyImages[imageIndex];
-}
-
-float Enemy::getShibaXListener()
-{
-	return shibaX;
-}
-
-void Enemy::setShibaXListener(float shibaXposition)
-{
-	shibaX = shibaXposition;
-}
-
-float Enemy::getShibaYListener()
-{
-	return shibaY;
-}
-
-void Enemy::setShibaYListener(float shibaYposition)
-{
-	shibaY = shibaYposition;
-}
-
-void Enemy::splitterSpawn(float Xposition, float Yposition)
-{
-	position[0] = Xposition;
-	position[1] = Yposition;
-	int eccentricty = 10;
-	velocity[0] = int((rand() % eccentricty) - 5);
-	velocity[1] = int((rand() % eccentricty) - 5);
-	imageIndex = 3;
-	imageUsed = &enemyImages[imageIndex];
-	textureUsed = JSglobalVars->textureArray[imageIndex];
-
-	sideLength = float(rand() % 20 + 15);
-
 	splitter = false;
+	imageIndex = 0;
 }
 
-void Enemy::spawn(float Xposition, float Yposition)
+ComponentMask enemyMask()
 {
-	int spawnchoice = (rand() % 4);
-	int spaceAway = 100;
-	bool enemySpawned = false;
-
-	//spawn top right area of game area
-	while (!enemySpawned) {
-		if (spawnchoice == 0) {
-			if ((Xposition + spaceAway) < JSglobalVars->gameXresolution && (Yposition + spaceAway) < JSglobalVars->gameXresolution) {
-				position[0] = (rand() % ((int)(JSglobalVars->gameXresolution - spaceAway + 1 - Xposition))) + Xposition + spaceAway;
-				position[1] = (rand() % ((int)(JSglobalVars->gameXresolution - spaceAway + 1 - Yposition))) + Yposition + spaceAway;
-				enemySpawned = true;
-#ifdef DEBUG
-				if (position[0] > JSglobalVars->gameXresolution || position[1] > JSglobalVars->gameXresolution) {
-					printf("Top right Error: %f, %f\n", position[0], position[1]);
-				}
-#endif
-			} else {
-				spawnchoice++;
-			}
-		}
-		//spawn top left area of shiba
-		if (spawnchoice == 1) {
-			if ((Xposition) > 0 && (Yposition + spaceAway) < JSglobalVars->gameXresolution) {
-				position[0] = (rand() % ((int)(Xposition - spaceAway + 1)));
-				position[1] = (rand() % ((int)(JSglobalVars->gameXresolution - spaceAway + 1 - Yposition))) + Yposition + spaceAway;
-				enemySpawned = true;
-#ifdef DEBUG
-				if (position[0] < 0 || position[1] > JSglobalVars->gameXresolution) {
-					printf("Top Left Error: %f, %f\n", position[0], position[1]);
-				}
-#endif
-			} else {
-				spawnchoice++;
-			}
-		}
-
-		// bottom right
-		if (spawnchoice == 2) {
-			if ((Xposition + spaceAway) < JSglobalVars->gameXresolution && (Yposition > 0)) {
-				position[0] = (rand() % ((int)(JSglobalVars->gameXresolution - spaceAway + 1 - Xposition))) + Xposition + spaceAway;
-				position[1] = (rand() % ((int)(Yposition - spaceAway + 1)));
-				enemySpawned = true;
-#ifdef DEBUG
-				if (position[0] > JSglobalVars->gameXresolution || position[1] < 0) {
-					printf("Bottom Right Error: %f, %f\n", position[0], position[1]);
-				}
-#endif
-			} else {
-				spawnchoice++;
-			}
-		}
-
-		// bottom left
-		if (spawnchoice == 3) {
-			if ((Xposition - spaceAway) > 0 && (Yposition - spaceAway > 0)) {
-				position[0] = (rand() % ((int)(Xposition - spaceAway + 1)));
-				position[1] = (rand() % ((int)(Yposition - spaceAway + 1)));
-				enemySpawned = true;
-#ifdef DEBUG
-				if (position[0] < 0 || position[1] < 0) {
-					printf("Bottom Left Error: %f, %f\n", position[0], position[1]);
-				}
-#endif
-			} else {
-				spawnchoice = 0;
-			}
-		}
-	} //end while
+	return maskOf<Position, Velocity, Size, EnemyInfo, HurtsShiba, BouncesOffEdges>();
 }
 
-void Enemy::drawEnemy()
+ComponentMask scatterShotMask()
 {
-	if (imageUsed == &enemyImages[3]) {
-		//HeMan sprite
-		drawSprite(textureUsed, *imageUsed, sideLength * 1.541, sideLength, position[0], position[1]);
-	} else {
-		drawSprite(textureUsed, *imageUsed, sideLength, sideLength, position[0], position[1]);
-	}
+	return maskOf<Position, Velocity, Size, ScatterShotTag, HurtsShiba, LeavesScreen>();
 }
 
-void Enemy::updatePosition(float shibaXposition, float shibaYposition, int indexOfEnemy)
+// Adds an enemy of the given size. The picture is picked from the size
+// and the big ones split up when they die.
+Entity EnemyControl::addEnemy(int size, float x, float y)
 {
-
-	if (position[0] < shibaXposition)
-		velocity[0] += speed;
-	if (position[0] > shibaXposition)
-		velocity[0] -= speed;
-	if (position[1] < shibaYposition)
-		velocity[1] += speed;
-	if (position[1] > shibaYposition)
-		velocity[1] -= speed;
-
-	position[0] = position[0] + velocity[0];
-	position[1] = position[1] + velocity[1];
-
-	if ((position[0] - sideLength) <= 0) {
-		position[0] = sideLength;
-		velocity[0] *= -1;
-	}
-	if ((position[0] + sideLength) >= JSglobalVars->gameXresolution) {
-		position[0] = JSglobalVars->gameXresolution - sideLength;
-		velocity[0] *= -1;
-	}
-	if ((position[1] - sideLength) <= 0) {
-		position[1] = sideLength;
-		velocity[1] *= -1;
-	}
-	if ((position[1] + sideLength) >= JSglobalVars->gameYresolution) {
-		position[1] = JSglobalVars->gameYresolution - sideLength;
-		velocity[1] *= -1;
+	Entity e = world.create(enemyMask());
+	Position *p = world.get<Position>(e);
+	p->x = x;
+	p->y = y;
+	world.get<Size>(e)->half = float(size);
+	EnemyInfo *info = world.get<EnemyInfo>(e);
+	if (size > 50) {
+		info->splitter = true;
 	}
 
-	//TODO MOVE TO OTHER FUNCTION===================================
-	for (unsigned int i = 0; i < scatterShotObject.size(); i++) {
-
-		if (scatterShotObject[i].position[0] < 0 || scatterShotObject[i].position[1] > JSglobalVars->gameXresolution) {
-			scatterShotObject.erase(scatterShotObject.begin() + i);
+	if (size <= 30) {
+		info->imageIndex = 0;
+	} else if (size > 30 && size <= 40) {
+		info->imageIndex = 1;
+	} else if (size > 40 && size <= 50) {
+		info->imageIndex = 4;
+	} else {
+		info->imageIndex = 2;
+	}
+	return e;
+}
+
+// Swept test: does the segment from (x0,y0) to (x0+dx,y0+dy) pass
+// through the open box of half width half around (cx,cy)? Clips the
+// segment against the x and y slabs of the box in turn. With dx and dy
+// zero this is the same point in box test used before.
+bool segmentHitsBox(float x0, float y0, float dx, float dy,
+		float cx, float cy, float half)
+{
+	float origin[2] = {x0, y0};
+	float dir[2] = {dx, dy};
+	float center[2] = {cx, cy};
+	float tEnter = 0.0f;
+	float tExit = 1.0f;
+	for (int axis = 0; axis < 2; axis++) {
+		float lo = center[axis] - half;
+		float hi = center[axis] + half;
+		if (dir[axis] == 0.0f) {
+			if (origin[axis] <= lo || origin[axis] >= hi)
+				return false;
+			continue;
 		}
-
-		if (scatterShotObject[i].position[1] < 0 || scatterShotObject[i].position[1] > JSglobalVars->gameYresolution) {
-			scatterShotObject.erase(scatterShotObject.begin() + i);
+		float t0 = (lo - origin[axis]) / dir[axis];
+		float t1 = (hi - origin[axis]) / dir[axis];
+		if (t0 > t1) {
+			float tmp = t0;
+			t0 = t1;
+			t1 = tmp;
 		}
-
-		if ((((scatterShotObject[i].position[0] - scatterShotObject[i].sideLength) < shibaXposition) &&
-				 ((scatterShotObject[i].position[0] + scatterShotObject[i].sideLength) > shibaXposition)) &&
-				(((scatterShotObject[i].position[1] - scatterShotObject[i].sideLength) < shibaYposition) &&
-				 ((scatterShotObject[i].position[1] + scatterShotObject[i].sideLength) > shibaYposition))) {
-				scatterShotObject.erase(scatterShotObject.begin() + i);
+		if (t0 > tEnter)
+			tEnter = t0;
+		if (t1 < tExit)
+			tExit = t1;
+		if (tEnter >= tExit)
+			return false;
+	}
+	return true;
+}
+
+// Steers every enemy a little towards the shiba. Each enemy only
+// changes its own velocity so the work is split across the job system.
+static void steerEnemies(float shibaXposition, float shibaYposition)
+{
+	world.each(maskOf<Position, Velocity, EnemyInfo>(), [&](Archetype &a) {
+		Position *p = a.get<Position>();
+		Velocity *v = a.get<Velocity>();
+		EnemyInfo *info = a.get<EnemyInfo>();
+		auto steer = [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				if (p[i].x < shibaXposition)
+					v[i].x += info[i].speed;
+				if (p[i].x > shibaXposition)
+					v[i].x -= info[i].speed;
+				if (p[i].y < shibaYposition)
+					v[i].y += info[i].speed;
+				if (p[i].y > shibaYposition)
+					v[i].y -= info[i].speed;
+			}
+		};
+		jobSystem.parallelFor(a.size(), 64, steer);
+	});
+}
+
+// Everything tagged HurtsShiba that touches the shiba costs a life and
+// is removed. Things that bounced were moved back on screen, so only
+// the others are checked along the whole step they took this tick.
+// The checks run in parallel, the lives and removals are applied in
+// order afterwards.
+static void shibaContact(float shibaXposition, float shibaYposition)
+{
+	static vector<char> contact;
+	world.each(maskOf<Position, Size, HurtsShiba>(), [&](Archetype &a) {
+		Position *p = a.get<Position>();
+		Size *s = a.get<Size>();
+		Velocity *v = a.get<Velocity>();
+		bool swept = v && !a.has(maskOf<BouncesOffEdges>());
+		contact.resize(a.size());
+		auto check = [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				float dx = swept ? v[i].x : 0.0f;
+				float dy = swept ? v[i].y : 0.0f;
+				contact[i] = segmentHitsBox(p[i].x - dx, p[i].y - dy, dx, dy,
+						shibaXposition, shibaYposition, s[i].half);
+			}
+		};
+		jobSystem.parallelFor(a.size(), 256, check);
+		for (int i = 0; i < a.size(); i++) {
+			if (contact[i]) {
 				numLivesLeft.changeLives(-1);
+				world.destroyLater(a.ids[i]);
+			}
 		}
-	}
-	renderScatterShot();
-
-	if ((((position[0] - sideLength) < shibaXposition) &&
-			 ((position[0] + sideLength) > shibaXposition)) &&
-			(((position[1] - sideLength) < shibaYposition) &&
-			 ((position[1] + sideLength) > shibaYposition))) {
-		enemyController.shibaCollision(indexOfEnemy);
-		numLivesLeft.changeLives(-1);
-	}
-
-#ifdef DEBUG
-	if (position[0] < -30)
-		printf("Enemy position error: Left of game window error\n");
-	if (position[0] > JSglobalVars->gameXresolution + 30)
-		printf("Enemy position error: right of game window error\n");
-	if (position[1] < -30)
-		printf("Enemy position error: below game window error\n");
-	if (position[1] > JSglobalVars->gameXresolution + 30)
-		printf("Enemy position error: Above game window error\n");
-#endif
-}
-
-void EnemyControl::shibaCollision(int indexOfEnemy)
-{
-	enemies.erase(enemies.begin() + indexOfEnemy);
-}
-
-void Enemy::takeDamage(int damageDone)
-{
-	health -= damageDone;
-}
-
-ScatterShot::ScatterShot()
-{
-	position[0] = rand() % 300;
-	position[1] = rand() % 300;
-	sideLength = 5;
-}
-
-void ScatterShot::drawShot()
-{
-	glBegin(GL_POLYGON);
-	glVertex2f(0, sideLength);
-	glVertex2f(sideLength, sideLength);
-	glVertex2f(sideLength, 0);
-	glVertex2f(0, 0);
-	glEnd();
+	});
+	world.flush();
 }
 
 void makeShots(float x, float y)
@@ -276,12 +176,16 @@ void makeShots(float x, float y)
 	int numToMake = 20;
 	float angle = 0;
 
+	world.reserve(scatterShotMask(), numToMake);
 	for (int i = 0; i < numToMake; i++) {
-		scatterShotObject.push_back(ScatterShot());
-		scatterShotObject.back().position[0] = x;
-		scatterShotObject.back().position[1] = y;
-		scatterShotObject.back().xDirection = cos(angle);
-		scatterShotObject.back().yDirection = sin(angle);
+		Entity e = world.create(scatterShotMask());
+		Position *p = world.get<Position>(e);
+		p->x = x;
+		p->y = y;
+		Velocity *v = world.get<Velocity>(e);
+		v->x = cos(angle) * scatterShotSpeed;
+		v->y = sin(angle) * scatterShotSpeed;
+		world.get<Size>(e)->half = 5;
 
 		if (angle > 2 * pi)
 			angle = 0;
@@ -301,39 +205,43 @@ void renderScatterShot()
 								{255, 127, 0},
 								{255, 0, 0}};
 
-	int slowDown = 5;
 	static int j = 0;
 	static int Timer = 0;
 
-	for (unsigned int i = 0; i < scatterShotObject.size(); i++) {
-		scatterShotObject[i].position[0] += (scatterShotObject[i].xDirection / slowDown);
-		scatterShotObject[i].position[1] += (scatterShotObject[i].yDirection / slowDown);
+	world.each(maskOf<Position, Size, ScatterShotTag>(), [&](Archetype &a) {
+		Position *p = a.get<Position>();
+		Size *s = a.get<Size>();
+		for (int i = 0; i < a.size(); i++) {
+			glPushMatrix();
+			glColor3ub(rainbowArray[j][0], rainbowArray[j][1], rainbowArray[j][2]);
+			glTranslated(p[i].x, p[i].y, 0);
+			glBegin(GL_POLYGON);
+			glVertex2f(0, s[i].half);
+			glVertex2f(s[i].half, s[i].half);
+			glVertex2f(s[i].half, 0);
+			glVertex2f(0, 0);
+			glEnd();
+			glPopMatrix();
+
+			if (Timer == 400) {
+				j++;
+				Timer = 0;
+			}
 
-		glPushMatrix();
-		glColor3ub(rainbowArray[j][0], rainbowArray[j][1], rainbowArray[j][2]);
-		glTranslated(scatterShotObject[i].position[0], scatterShotObject[i].position[1], 0);
-		scatterShotObject[i].drawShot();
-		glPopMatrix();
+			if (j == 7)
+				j = 0;
 
-		if (Timer == 400) {
-			j++;
-			Timer = 0;
+			Timer++;
 		}
-
-		if (j == 7) 
-			j = 0;
-
-		Timer++;
-	}
+	});
 }
 
 void cleanUpShots()
 {
-	while(scatterShotObject.size() > 0){
-		scatterShotObject.erase(scatterShotObject.begin());
-	}
+	world.clear(maskOf<ScatterShotTag>());
 }
 
+
 //=============================================================
 //		Score Display
 //=============================================================
@@ -360,11 +268,12 @@ void Lives::changeLives(int difference)
 
 void Lives::livesTextDisplay()
 {
+	static TextLabel label;
 	Rect livesLeft;
 	livesLeft.left = JSglobalVars->gameXresolution * .010;
 	livesLeft.bot = JSglobalVars->gameYresolution * .010;
 	livesLeft.center = 0;
-	ggprint16(&livesLeft, 16, 0x00ffff00, "Lives: %d", numLivesLeft.getLives());
+	label.print(&livesLeft, 16, 0x00ffff00, "Lives: %d", numLivesLeft.getLives());
 }
 
 Score::Score()
@@ -394,11 +303,12 @@ float Score::getScore()
 
 void Score::textScoreDisplay()
 {
+	static TextLabel label;
 	Rect score;
 	score.left = JSglobalVars->gameXresolution * .87;
 	score.bot = JSglobalVars->gameYresolution * .010;
 	score.center = 0;
-	ggprint16(&score, 16, 0x00ffff00, "Score: %010.0f", scoreObject.getScore());
+	label.print(&score, 16, 0x00ffff00, "Score: %010.0f", scoreObject.getScore());
 }
 //=============================================================
 // Functions used in Main file
@@ -406,110 +316,207 @@ void Score::textScoreDisplay()
 
 void EnemyControl::createSplitEnemy(float xPosition, float yPosition)
 {
+	int eccentricty = 10;
 	for (int i = 0; i < 5; i++) {
-		enemies.push_back(Enemy());
-		enemies.back().splitterSpawn(xPosition, yPosition);
+		float vx = int(rngStreams[RNG_ENEMY].below(eccentricty) - 5);
+		float vy = int(rngStreams[RNG_ENEMY].below(eccentricty) - 5);
+		int size = rngStreams[RNG_ENEMY].below(20) + 15;
+		Entity e = addEnemy(size, xPosition, yPosition);
+		Velocity *v = world.get<Velocity>(e);
+		v->x = vx;
+		v->y = vy;
+		EnemyInfo *info = world.get<EnemyInfo>(e);
+		info->imageIndex = 3;
+		info->splitter = false;
 	}
 }
 
 void EnemyControl::createEnemy(int numToCreate, float shibaXPosition, float shibaYPosition)
 {
-	for (int i = 0; i < numToCreate; i++) {
-		enemies.push_back(Enemy());
-		//cout << shibaXPosition << endl;
-		enemies.back().setShibaXListener(shibaXPosition);
-		enemies.back().setShibaYListener(shibaYPosition);
-		enemies.back().spawn(enemies.back().getShibaXListener(), enemies.back().getShibaYListener());
-	}
+	// draw all the sizes and spots in one go, anywhere on screen but
+	// not within spawnSpaceAway of the shiba
+	if (numToCreate <= 0)
+		return;
+	ArenaScope scope;
+	ArenaVector<int> sizes(numToCreate);
+	ArenaVector<float> spots(numToCreate * 2);
+	rngStreams[RNG_ENEMY].fillBelow(&sizes[0], numToCreate, 60);
+	SpawnRegion region;
+	region.build(JSglobalVars->gameXresolution, JSglobalVars->gameYresolution,
+			shibaXPosition, shibaYPosition, spawnSpaceAway);
+	region.sampleMany(rngStreams[RNG_SPAWN], numToCreate, &spots[0]);
+	world.reserve(enemyMask(), numToCreate);
+	for (int i = 0; i < numToCreate; i++)
+		addEnemy(sizes[i] + 15, spots[i * 2], spots[i * 2 + 1]);
+}
+
+// kills the enemy at index, it splits up on the next update like one
+// that was shot
+void EnemyControl::destroyEnemy(int index)
+{
+	world.each(maskOf<EnemyInfo>(), [&](Archetype &a) {
+		if (index >= 0 && index < a.size())
+			a.get<EnemyInfo>()[index].health = 0;
+		index -= a.size();
+	});
 }
 
-// destroys an element in a vector by it's index
-void EnemyControl::destroyEnemy(int index)
+int EnemyControl::count()
 {
-	if (enemies.size() > 0) {
-		if (enemies[index].splitter == true) {
-			float positionX = enemies[index].position[0];
-			float positionY = enemies[index].position[1];
-			makeShots(positionX, positionY);
-			createSplitEnemy(positionX, positionY);
-		}
-		enemies.erase(enemies.begin() + index);
-	}
+	return world.count(maskOf<EnemyInfo>());
 }
 
 void EnemyControl::renderEnemies()
 {
-	for (unsigned int i = 0; i < enemies.size(); i++) {
-		enemies[i].drawEnemy();
-		updateFrame(*(enemies[i].imageUsed), enemies[i].timer, 3.0);
-	}
+	world.each(maskOf<Position, Size, EnemyInfo>(), [](Archetype &a) {
+		Position *p = a.get<Position>();
+		Size *s = a.get<Size>();
+		EnemyInfo *info = a.get<EnemyInfo>();
+		for (int i = 0; i < a.size(); i++) {
+			Image *img = &enemyImages[info[i].imageIndex];
+			GLuint tex = JSglobalVars->textureArray[info[i].imageIndex];
+			if (info[i].imageIndex == 3) {
+				//HeMan sprite
+				drawSprite(tex, *img, s[i].half * 1.541, s[i].half, p[i].x, p[i].y);
+			} else {
+				drawSprite(tex, *img, s[i].half, s[i].half, p[i].x, p[i].y);
+			}
+			updateFrame(*img, info[i].timer, 3.0);
+		}
+	});
+	renderScatterShot();
 }
 
+// One tick for everything that hurts the shiba: enemies steer, then
+// enemies and scatter shots move, bounce or leave the screen, and
+// anything touching the shiba is used up. Enemies shot down since the
+// last tick are removed last, splitters breaking up in order.
 void EnemyControl::updateAllPosition(float shibaXposition, float shibaYposition)
 {
-	for (unsigned int i = 0; i < enemies.size(); i++) {
-		enemies[i].updatePosition(shibaXposition, shibaYposition, i);
-		if (enemies[i].health < 1) {
-			destroyEnemy(i);
+	float xres = JSglobalVars->gameXresolution;
+	float yres = JSglobalVars->gameYresolution;
+	ComponentMask harmful = maskOf<HurtsShiba>();
+	steerEnemies(shibaXposition, shibaYposition);
+	moveEntities(harmful);
+	bounceEntities(harmful, xres, yres);
+	cullEntities(harmful, xres, yres);
+	shibaContact(shibaXposition, shibaYposition);
+
+	splits.clear();
+	world.each(maskOf<Position, EnemyInfo>(), [&](Archetype &a) {
+		Position *p = a.get<Position>();
+		EnemyInfo *info = a.get<EnemyInfo>();
+		for (int i = 0; i < a.size(); i++) {
+			if (info[i].health >= 1)
+				continue;
+			if (info[i].splitter) {
+				splits.push_back(p[i].x);
+				splits.push_back(p[i].y);
+			}
+			world.destroyLater(a.ids[i]);
 		}
+	});
+	world.flush();
+	for (unsigned int i = 0; i < splits.size(); i += 2) {
+		makeShots(splits[i], splits[i + 1]);
+		createSplitEnemy(splits[i], splits[i + 1]);
 	}
 }
 
+// Checks every bullet against every enemy. Each bullet is tested along
+// the path it moved this tick, (x - vx, y - vy) to (x, y), so fast
+// bullets cannot skip over small enemies. The scan only reads enemy
+// state so it runs in parallel; damage and score are then applied in
+// bullet order, and every enemy a bullet passed through takes the hit.
+void EnemyControl::bulletHits()
+{
+	struct Target {
+		float x, y, half;
+		EnemyInfo *info;
+	};
+	static vector<Target> targets;
+	static vector<char> hit;
+	targets.clear();
+	world.each(maskOf<Position, Size, EnemyInfo>(), [&](Archetype &a) {
+		Position *p = a.get<Position>();
+		Size *s = a.get<Size>();
+		EnemyInfo *info = a.get<EnemyInfo>();
+		for (int i = 0; i < a.size(); i++) {
+			Target t = {p[i].x, p[i].y, s[i].half, &info[i]};
+			targets.push_back(t);
+		}
+	});
+	int n = targets.size();
+	if (n == 0)
+		return;
+	world.each(maskOf<Position, Velocity, HurtsEnemies>(), [&](Archetype &a) {
+		Position *p = a.get<Position>();
+		Velocity *v = a.get<Velocity>();
+		hit.resize(a.size());
+		auto scanBullets = [&](int begin, int end) {
+			for (int b = begin; b < end; b++) {
+				hit[b] = 0;
+				for (int j = 0; j < n; j++) {
+					if (segmentHitsBox(p[b].x - v[b].x, p[b].y - v[b].y, v[b].x, v[b].y,
+							targets[j].x, targets[j].y, targets[j].half)) {
+						hit[b] = 1;
+						break;
+					}
+				}
+			}
+		};
+		jobSystem.parallelFor(a.size(), 16, scanBullets);
+		for (int b = 0; b < a.size(); b++) {
+			if (!hit[b])
+				continue;
+			for (int j = 0; j < n; j++) {
+				if (segmentHitsBox(p[b].x - v[b].x, p[b].y - v[b].y, v[b].x, v[b].y,
+						targets[j].x, targets[j].y, targets[j].half)) {
+					targets[j].info->health -= 100;
+					scoreObject.changeScore(scoreObject.calculateScore(targets[j].half));
+				}
+			}
+			//removes bullet if hit
+			world.destroyLater(a.ids[b]);
+		}
+	});
+	world.flush();
+}
+
 void EnemyControl::cleanupEnemies()
 {
-	while (enemies.size() != 0) {
-		enemies.pop_back();
-	}
+	world.clear(maskOf<EnemyInfo>());
 }
 
-bool EnemyControl::bulletHitEnemy(float bulletX, float bulletY)
+EnemyControl::EnemyControl()
 {
-	bool hit = false;
-	for (unsigned int j = 0; j < enemies.size(); j++) {
-		if ((bulletX - enemies[j].sideLength < enemies[j].position[0]) &&
-				(bulletX + enemies[j].sideLength > enemies[j].position[0]) &&
-				(bulletY + enemies[j].sideLength > enemies[j].position[1]) &&
-				(bulletY - enemies[j].sideLength < enemies[j].position[1])) {
-
-			enemies[j].takeDamage(100);
-			hit = true;
-			scoreObject.changeScore(scoreObject.calculateScore(enemies[j].sideLength));
-		}
-	}
-	return hit;
+	enemyCap = 10;
 }
 
-void EnemyControl::primeSpawner(int milliseconds, float shibaXposition, float shibaYposition)
+// runWaves(): called once per physics tick, plays the wave schedule
+void EnemyControl::runWaves(float shibaXposition, float shibaYposition)
 {
-	int primeArray[] = {101, 103, 107, 109, 113};
-
-	static int currentIndex = sizeof(primeArray) / sizeof(primeArray[0]) - 1;
-	static int numToMake = 1;
-
-	int spawnChecker = (milliseconds % primeArray[currentIndex]);
-	unsigned int enemyCap = 10;
-	if (enemies.size() < 1) {
-		createEnemy(5, shibaXposition, shibaYposition);
+	if (count() < 1) {
+		createEnemy(waves.keepAliveCount(), shibaXposition, shibaYposition);
 	}
-	if (spawnChecker == 0 && enemies.size() < enemyCap) {
-		createEnemy(numToMake, shibaXposition, shibaYposition);
-		if (currentIndex > 0) {
-			--currentIndex;
-		} else {
-			currentIndex = sizeof(primeArray) / sizeof(primeArray[0]) - 1;
-			numToMake++;
+	const WaveEvent *due;
+	int n = waves.step(&due);
+	for (int i = 0; i < n; i++) {
+		if (due[i].type == WAVE_CAP) {
+			enemyCap = due[i].value;
+			continue;
+		}
+		int room = enemyCap - count();
+		int make = due[i].value < room ? due[i].value : room;
+		if (make > 0) {
+			createEnemy(make, shibaXposition, shibaYposition);
 		}
-	}
-
-	if (milliseconds % 401 == 0) {
-		enemyCap++;
 	}
 }
 
 Lives numLivesLeft;
 Score scoreObject;
 EnemyControl enemyController;
-vector<ScatterShot> scatterShotObject;
 
 void getTexturesFunction(GLuint recievedTexture)
 {
@@ -526,7 +533,8 @@ void josephS(float x, float y, GLuint textid)
 	name.left = x + 90;
 	name.bot = y;
 	name.center = 0;
-	ggprint16(&name, 16, 0x00ffff00, "Joseph Shafer");
+	static TextLabel label;
+	label.print(&name, 16, 0x00ffff00, "Joseph Shafer");
 	glColor3ub(225, 225, 225);
 	float wid = 60.0f;
 	glPushMatrix();
@@ -544,3 +552,86 @@ void josephS(float x, float y, GLuint textid)
 	glEnd();
 	glPopMatrix();
 }
+
+//=============================================================
+// Scaling benchmark: ./shiba --bench-jobs
+//=============================================================
+
+static double benchSeconds()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// Runs the same crowd of enemies for a fixed number of ticks with 1..N
+// workers and prints ms per tick and the speedup over one worker. Each
+// run has to end in exactly the same state as the single worker run.
+static void enemyPositions(vector<float> &out)
+{
+	out.clear();
+	world.each(maskOf<Position, EnemyInfo>(), [&](Archetype &a) {
+		Position *p = a.get<Position>();
+		for (int i = 0; i < a.size(); i++) {
+			out.push_back(p[i].x);
+			out.push_back(p[i].y);
+		}
+	});
+}
+
+void enemyScalingBenchmark()
+{
+	const int numEnemies = 20000;
+	const int ticks = 300;
+	float shibaX = JSglobalVars->gameXresolution / 2;
+	float shibaY = JSglobalVars->gameYresolution / 2;
+
+	rngSeed(1);
+	enemyController.cleanupEnemies();
+	cleanUpShots();
+	enemyController.createEnemy(numEnemies, shibaX, shibaY);
+	int numShots = numEnemies / 20;
+	for (int i = 0; i < numShots; i++) {
+		Entity e = world.create(scatterShotMask());
+		Position *p = world.get<Position>(e);
+		p->x = rngStreams[RNG_SCATTER].below(300);
+		p->y = rngStreams[RNG_SCATTER].below(300);
+		Velocity *v = world.get<Velocity>(e);
+		v->x = cos(i * 0.1f) * scatterShotSpeed;
+		v->y = sin(i * 0.1f) * scatterShotSpeed;
+		world.get<Size>(e)->half = 5;
+	}
+	World start = world;
+
+	int maxWorkers = thread::hardware_concurrency();
+	if (maxWorkers < 1)
+		maxWorkers = 1;
+	vector<float> reference, result;
+	int referenceLives = 0;
+	double base = 0;
+	printf("%d enemies, %d shots, %d ticks\n", numEnemies, numShots, ticks);
+	printf("workers   ms/tick   speedup   same result\n");
+	for (int w = 1; w <= maxWorkers; w++) {
+		jobSystem.start(w);
+		world = start;
+		numLivesLeft.setLives(0);
+		double t0 = benchSeconds();
+		for (int t = 0; t < ticks; t++)
+			enemyController.updateAllPosition(shibaX, shibaY);
+		double ms = (benchSeconds() - t0) * 1000.0 / ticks;
+		bool same = true;
+		if (w == 1) {
+			base = ms;
+			enemyPositions(reference);
+			referenceLives = numLivesLeft.getLives();
+		} else {
+			enemyPositions(result);
+			same = result == reference && numLivesLeft.getLives() == referenceLives;
+		}
+		printf("%7d %9.3f %9.2f   %s\n", w, ms, base / ms, same ? "yes" : "NO");
+	}
+	enemyController.cleanupEnemies();
+	cleanUpShots();
+	numLivesLeft.setLives(3);
+	jobSystem.stop();
+}
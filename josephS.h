@@ -9,6 +9,8 @@
 #include <stdio.h>
 #include "amberZ.h"
 #include "Image.h"
+#include "text.h"
+#include "ecs.h"
 #define numEnemyImages 5
 using namespace std;
 
@@ -39,66 +41,41 @@ public:
 
 
 void enemyGetResolution(float, float);
+bool segmentHitsBox(float, float, float, float, float, float, float);
 
 
-class ScatterShot{
-    public:
-        float position[2];
-        float sideLength;
-        float xDirection;
-        float yDirection;
-
-        void drawShot();
-
-    ScatterShot();
-};
-
-
-
-class Enemy{
-public:
-
-    float shibaX;
-    float shibaY;
-    float position[2];
-    float velocity[2];
-    float sideLength;
-    float speed;
+// Enemy specific data, the rest of an enemy is Position, Velocity and Size
+struct EnemyInfo {
     int health;
-    GLuint textureUsed;
-    Image* imageUsed;
+    float speed;
+    bool splitter;
     int imageIndex;
-    bool splitter = false;
-
-    
     SpriteTimer timer;
-    void splitterSpawn(float, float);
-    void spawn(float, float);
-    float getShibaXListener();
-    float getShibaYListener();
-    void setShibaXListener(float);
-    void setShibaYListener(float);
-    void drawEnemy();
-    void updatePosition(float, float, int);
-    void takeDamage(int);
-    void setTexture();
-    void scatterShot();
-    Enemy();
+    EnemyInfo();
 };
 
+// Tag for the rainbow squares a big enemy breaks into
+struct ScatterShotTag {};
+
+ComponentMask enemyMask();
+ComponentMask scatterShotMask();
+
 class EnemyControl{
     public:
-        vector<Enemy> enemies;
-        void shibaCollision(int);
+        vector<float> splits;
+        // most enemies allowed on screen, raised by the wave schedule
+        int enemyCap;
+        Entity addEnemy(int, float, float);
         void createEnemy(int, float, float);
         void destroyEnemy(int);
         void renderEnemies();
         void updateAllPosition(float, float);
         void cleanupEnemies();
-        bool bulletHitEnemy(float, float);
-        void primeSpawner(int, float, float);
+        void bulletHits();
+        void runWaves(float, float);
         void createSplitEnemy(float, float);
-        //EnemyControl();
+        int count();
+        EnemyControl();
 };
 
 class Lives{
@@ -125,13 +102,17 @@ class Score{
 extern Lives numLivesLeft;
 extern Score scoreObject;
 extern EnemyControl enemyController;
-extern vector<ScatterShot> scatterShotObject;
 extern Image enemyImages[numEnemyImages];
 void getTexturesFunction(GLuint);
+// enemies never appear closer than this to the shiba
+const float spawnSpaceAway = 100.0f;
+// scatter shots move this many pixels per physics tick
+const float scatterShotSpeed = 1.0f;
 void renderScatterShot();
 void makeShots(float, float);
 void cleanUpShots();
 extern void josephS(float, float, GLuint);
+extern void enemyScalingBenchmark();
 
 
 #endif
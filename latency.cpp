@@ -0,0 +1,208 @@
+//Program: latency.cpp
+//Input-to-photon latency harness for Shiba Survival
+//
+//Run the game with SHIBA_LATENCY_PROBE set (see latency.sh), then this
+//program starts a run from the menu and repeatedly presses an arrow key
+//through XTest. After each press it polls the window contents around the
+//shiba until they change, and the time between injecting the key and
+//seeing the sprite move is one latency sample.
+//
+//usage: ./latency [-n trials] [-l label]
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XTest.h>
+
+//half size of the box watched around the shiba, and how many pixels
+//have to change before we call it a move
+const int PROBE_HALF = 48;
+const int PROBE_THRESHOLD = 20;
+const double PROBE_TIMEOUT = 1.0;
+
+static double now()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void sleepFor(double seconds)
+{
+	usleep((useconds_t)(seconds * 1e6));
+}
+
+static Window findWindow(Display *dpy, Window w, const char *name)
+{
+	char *wname = NULL;
+	if (XFetchName(dpy, w, &wname) && wname) {
+		bool match = (strcmp(wname, name) == 0);
+		XFree(wname);
+		if (match)
+			return w;
+	}
+	Window root, parent, *kids = NULL;
+	unsigned int nkids = 0;
+	Window found = 0;
+	if (XQueryTree(dpy, w, &root, &parent, &kids, &nkids)) {
+		for (unsigned int i = 0; i < nkids && !found; i++)
+			found = findWindow(dpy, kids[i], name);
+		if (kids)
+			XFree(kids);
+	}
+	return found;
+}
+
+static void tapKey(Display *dpy, KeySym sym)
+{
+	KeyCode kc = XKeysymToKeycode(dpy, sym);
+	XTestFakeKeyEvent(dpy, kc, True, 0);
+	XTestFakeKeyEvent(dpy, kc, False, 0);
+	XSync(dpy, False);
+}
+
+//grab(): copy the probe box out of the window
+static bool grab(Display *dpy, Window win, int x, int y, std::vector<unsigned long> &px)
+{
+	XImage *img = XGetImage(dpy, win, x, y, PROBE_HALF * 2, PROBE_HALF * 2,
+		AllPlanes, ZPixmap);
+	if (!img)
+		return false;
+	px.resize(PROBE_HALF * 2 * PROBE_HALF * 2);
+	for (int j = 0; j < PROBE_HALF * 2; j++)
+		for (int i = 0; i < PROBE_HALF * 2; i++)
+			px[j * PROBE_HALF * 2 + i] = XGetPixel(img, i, j);
+	XDestroyImage(img);
+	return true;
+}
+
+static int countChanged(const std::vector<unsigned long> &a,
+	const std::vector<unsigned long> &b)
+{
+	int n = 0;
+	for (unsigned int i = 0; i < a.size(); i++)
+		n += (a[i] != b[i]);
+	return n;
+}
+
+static double percentile(const std::vector<double> &v, double p)
+{
+	unsigned int i = (unsigned int)(p * (v.size() - 1) + 0.5);
+	return v[i];
+}
+
+int main(int argc, char *argv[])
+{
+	int trials = 100;
+	const char *label = "shiba";
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			trials = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+			label = argv[++i];
+	}
+	Display *dpy = XOpenDisplay(NULL);
+	if (dpy == NULL) {
+		printf("latency: cannot connect to X server\n");
+		return 1;
+	}
+	int ev, er, maj, min;
+	if (!XTestQueryExtension(dpy, &ev, &er, &maj, &min)) {
+		printf("latency: XTest extension not available\n");
+		return 1;
+	}
+	Window win = 0;
+	for (int i = 0; i < 100 && !win; i++) {
+		win = findWindow(dpy, DefaultRootWindow(dpy), "Shiba Survival");
+		if (!win)
+			sleepFor(0.1);
+	}
+	if (!win) {
+		printf("latency: game window not found\n");
+		return 1;
+	}
+	XWindowAttributes wa;
+	XGetWindowAttributes(dpy, win, &wa);
+	//the shiba starts in the middle of the window
+	int px = wa.width / 2 - PROBE_HALF;
+	int py = wa.height / 2 - PROBE_HALF;
+
+	//Play is the first menu entry
+	XSetInputFocus(dpy, win, RevertToParent, CurrentTime);
+	tapKey(dpy, XK_Return);
+	sleepFor(1.0);
+
+	std::vector<double> samples;
+	std::vector<unsigned long> ref, cur;
+	int timeouts = 0;
+	for (int t = 0; t < trials; t++) {
+		//alternate directions so the shiba stays inside the probe box
+		KeySym sym = (t & 1) ? XK_Left : XK_Right;
+		KeyCode kc = XKeysymToKeycode(dpy, sym);
+		if (!grab(dpy, win, px, py, ref))
+			break;
+		double t0 = now();
+		XTestFakeKeyEvent(dpy, kc, True, 0);
+		XSync(dpy, False);
+		bool seen = false;
+		while (now() - t0 < PROBE_TIMEOUT) {
+			if (!grab(dpy, win, px, py, cur))
+				break;
+			if (countChanged(ref, cur) >= PROBE_THRESHOLD) {
+				seen = true;
+				break;
+			}
+		}
+		double t1 = now();
+		XTestFakeKeyEvent(dpy, kc, False, 0);
+		XSync(dpy, False);
+		if (seen)
+			samples.push_back((t1 - t0) * 1000.0);
+		else
+			timeouts++;
+		//let the sprite settle back to its idle frame
+		sleepFor(0.25);
+	}
+	tapKey(dpy, XK_Escape);
+	XCloseDisplay(dpy);
+
+	if (samples.empty()) {
+		printf("latency: no movement detected in %d trials\n", trials);
+		return 1;
+	}
+	std::sort(samples.begin(), samples.end());
+	double sum = 0.0;
+	for (unsigned int i = 0; i < samples.size(); i++)
+		sum += samples[i];
+	printf("input-to-photon latency for %s, %d samples, %d timeouts (ms)\n",
+		label, (int)samples.size(), timeouts);
+	printf("  min %.2f  mean %.2f  p50 %.2f  p90 %.2f  p99 %.2f  max %.2f\n",
+		samples.front(), sum / samples.size(), percentile(samples, 0.5),
+		percentile(samples, 0.9), percentile(samples, 0.99), samples.back());
+	//histogram in 4 ms buckets
+	const double bucket = 4.0;
+	int nb = (int)(samples.back() / bucket) + 1;
+	std::vector<int> hist(nb, 0);
+	for (unsigned int i = 0; i < samples.size(); i++)
+		hist[(int)(samples[i] / bucket)]++;
+	for (int b = 0; b < nb; b++) {
+		if (!hist[b])
+			continue;
+		printf("  %5.0f-%-5.0f %5d ", b * bucket, (b + 1) * bucket, hist[b]);
+		for (int i = 0; i < hist[b] * 50 / (int)samples.size() + 1; i++)
+			putchar('#');
+		putchar('\n');
+	}
+	//one machine readable line per build for comparing runs
+	printf("csv,%s,%d,%.3f,%.3f,%.3f,%.3f,%.3f\n", label, (int)samples.size(),
+		samples.front(), percentile(samples, 0.5), percentile(samples, 0.9),
+		percentile(samples, 0.99), samples.back());
+	return 0;
+}
@@ -0,0 +1,22 @@
+#!/bin/sh
+# latency.sh: measure input-to-photon latency of a game build under Xvfb
+# with software GL.
+# usage: ./latency.sh [game binary] [label] [trials]
+BIN=${1:-./shiba}
+LABEL=${2:-$BIN}
+TRIALS=${3:-100}
+DPY=:99
+
+Xvfb $DPY -screen 0 1366x768x24 >/dev/null 2>&1 &
+XVFB=$!
+sleep 1
+export DISPLAY=$DPY
+export LIBGL_ALWAYS_SOFTWARE=1
+export SHIBA_LATENCY_PROBE=1
+$BIN latency >/dev/null 2>&1 &
+GAME=$!
+./latency -n "$TRIALS" -l "$LABEL"
+STATUS=$?
+kill $GAME $XVFB 2>/dev/null
+wait 2>/dev/null
+exit $STATUS
@@ -4,6 +4,7 @@
 
 #include <GL/glx.h>
 #include "fonts.h"
+#include "text.h"
 
 void mabelleC(int x, int y, GLuint id)
 {
@@ -14,7 +15,8 @@ void mabelleC(int x, int y, GLuint id)
 	r.bot = y;
 	r.left = x + 90;
 	r.center = 0;
-	ggprint16(&r, 16, 0x00ffff00, "Mabelle Cruz");
+	static TextLabel name;
+	name.print(&r, 16, 0x00ffff00, "Mabelle Cruz");
 	// Displays my picture
 	glColor3ub(255, 255, 255);
 	glPushMatrix();
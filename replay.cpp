@@ -0,0 +1,262 @@
+//Program: replay.cpp
+//Seekable replays for Shiba Survival
+//
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "replay.h"
+#include "snapshot.h"
+#include "log.h"
+
+#define REPLAY_MAGIC 0x50524853
+#define REPLAY_BLOCK_MAGIC 0x4b4c4248
+
+ReplayWriter::ReplayWriter()
+{
+	fp = NULL;
+}
+
+ReplayWriter::~ReplayWriter()
+{
+	close();
+}
+
+bool ReplayWriter::open(const char *path, uint64_t seed, unsigned int firstTick)
+{
+	close();
+	fp = fopen(path, "wb");
+	if (!fp) {
+		Log("replay: cannot write %s\n", path);
+		return false;
+	}
+	memset(&head, 0, sizeof head);
+	head.magic = REPLAY_MAGIC;
+	head.version = REPLAY_VERSION;
+	head.snapshotVersion = SNAPSHOT_VERSION;
+	head.keyframeTicks = REPLAY_KEYFRAME_TICKS;
+	head.seed = seed;
+	head.firstTick = firstTick;
+	index.clear();
+	fwrite(&head, sizeof head, 1, fp);
+	Log("replay: recording to %s from tick %u\n", path, firstTick);
+	return true;
+}
+
+//pad(): up to the next multiple of 8
+void ReplayWriter::pad()
+{
+	static const char zeros[8] = {0};
+	long at = ftell(fp);
+	if (at % 8)
+		fwrite(zeros, 8 - at % 8, 1, fp);
+}
+
+bool ReplayWriter::wantsKeyframe() const
+{
+	return fp && head.ticks % REPLAY_KEYFRAME_TICKS == 0;
+}
+
+void ReplayWriter::keyframe(const std::vector<unsigned char> &snapshot)
+{
+	ReplayKeyframe k;
+	ReplayBlock b;
+	pad();
+	k.tick = head.firstTick + head.ticks;
+	k.inputs = 0;
+	b.magic = REPLAY_BLOCK_MAGIC;
+	b.tick = k.tick;
+	b.snapshotLength = snapshot.size();
+	b.checksum = snapshotChecksum(snapshot.empty() ? NULL : &snapshot[0],
+		snapshot.size());
+	b.pad = 0;
+	fwrite(&b, sizeof b, 1, fp);
+	k.snapshot = ftell(fp);
+	k.snapshotLength = snapshot.size();
+	if (!snapshot.empty())
+		fwrite(&snapshot[0], snapshot.size(), 1, fp);
+	pad();
+	k.inputOffset = ftell(fp);
+	index.push_back(k);
+	//the keys before it and the snapshot survive a crash from here on
+	fflush(fp);
+}
+
+void ReplayWriter::input(const ReplayInput &in)
+{
+	//without a keyframe to start from these ticks could not be played
+	if (index.empty())
+		return;
+	fwrite(&in, sizeof in, 1, fp);
+	index.back().inputs++;
+	head.ticks++;
+}
+
+void ReplayWriter::close()
+{
+	if (!fp)
+		return;
+	pad();
+	head.index = ftell(fp);
+	head.keyframes = index.size();
+	if (!index.empty())
+		fwrite(&index[0], sizeof(ReplayKeyframe), index.size(), fp);
+	fseek(fp, 0, SEEK_SET);
+	fwrite(&head, sizeof head, 1, fp);
+	fclose(fp);
+	fp = NULL;
+	Log("replay: %u ticks, %u keyframes\n", head.ticks, head.keyframes);
+}
+
+ReplayFile::ReplayFile()
+{
+	fd = -1;
+	map = NULL;
+	length = 0;
+	head = NULL;
+	index = NULL;
+	ticks = 0;
+	nkeyframes = 0;
+}
+
+ReplayFile::~ReplayFile()
+{
+	close();
+}
+
+//checkIndex(): every offset in a finished file's index, once, so
+//nothing after this has to
+bool ReplayFile::checkIndex()
+{
+	if (head->keyframes == 0 || head->index % 8 != 0 ||
+			head->index + head->keyframes * sizeof(ReplayKeyframe) > length)
+		return false;
+	index = (const ReplayKeyframe *)(map + head->index);
+	nkeyframes = head->keyframes;
+	ticks = 0;
+	for (int k = 0; k < nkeyframes; k++) {
+		const ReplayKeyframe &f = index[k];
+		if (f.tick != head->firstTick + k * REPLAY_KEYFRAME_TICKS ||
+				f.snapshot < (int64_t)(sizeof(ReplayHeader) + sizeof(ReplayBlock)) ||
+				f.snapshotLength <= 0 ||
+				f.snapshot + f.snapshotLength > head->index ||
+				f.inputOffset % 4 != 0 ||
+				f.inputOffset + f.inputs * sizeof(ReplayInput) > (uint64_t)head->index ||
+				(f.inputs != REPLAY_KEYFRAME_TICKS && k != nkeyframes - 1))
+			return false;
+		ticks += f.inputs;
+	}
+	return ticks == head->ticks;
+}
+
+//rebuildIndex(): walks the blocks of a recording that was never closed.
+//A block whose snapshot is cut short or does not match its checksum
+//ends the walk, and so do keys that stop part way through a block.
+bool ReplayFile::rebuildIndex()
+{
+	rebuilt.clear();
+	int64_t at = sizeof(ReplayHeader);
+	while (at + (int64_t)sizeof(ReplayBlock) <= (int64_t)length) {
+		const ReplayBlock *b = (const ReplayBlock *)(map + at);
+		ReplayKeyframe f;
+		f.tick = head->firstTick + rebuilt.size() * REPLAY_KEYFRAME_TICKS;
+		f.snapshot = at + sizeof(ReplayBlock);
+		f.snapshotLength = b->snapshotLength;
+		if (b->magic != REPLAY_BLOCK_MAGIC || b->tick != f.tick ||
+				f.snapshotLength <= 0 ||
+				f.snapshotLength > (int64_t)length - f.snapshot ||
+				snapshotChecksum(map + f.snapshot, f.snapshotLength) != b->checksum)
+			break;
+		f.inputOffset = (f.snapshot + f.snapshotLength + 7) & ~7;
+		int64_t keys = f.inputOffset < (int64_t)length ?
+			((int64_t)length - f.inputOffset) / sizeof(ReplayInput) : 0;
+		f.inputs = keys < REPLAY_KEYFRAME_TICKS ? keys : REPLAY_KEYFRAME_TICKS;
+		rebuilt.push_back(f);
+		ticks += f.inputs;
+		if (f.inputs < REPLAY_KEYFRAME_TICKS)
+			break;
+		at = f.inputOffset + REPLAY_KEYFRAME_TICKS * sizeof(ReplayInput);
+	}
+	if (rebuilt.empty())
+		return false;
+	index = &rebuilt[0];
+	nkeyframes = rebuilt.size();
+	return true;
+}
+
+//open(): maps the file and checks it once, rebuilding the index of a
+//recording that was cut short
+bool ReplayFile::open(const char *path)
+{
+	close();
+	fd = ::open(path, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(ReplayHeader)) {
+		Log("replay: cannot read %s\n", path);
+		close();
+		return false;
+	}
+	length = st.st_size;
+	void *p = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (p == MAP_FAILED) {
+		map = NULL;
+		close();
+		return false;
+	}
+	map = (const unsigned char *)p;
+	head = (const ReplayHeader *)map;
+	bool ok = head->magic == REPLAY_MAGIC && head->version == REPLAY_VERSION &&
+		head->snapshotVersion == SNAPSHOT_VERSION &&
+		head->keyframeTicks == REPLAY_KEYFRAME_TICKS;
+	if (ok && head->index == 0) {
+		ok = rebuildIndex();
+		if (ok)
+			Log("replay: %s was not finished, recovered %u ticks in %d "
+				"keyframes\n", path, ticks, nkeyframes);
+	} else if (ok) {
+		ok = checkIndex();
+	}
+	if (!ok) {
+		Log("replay: %s is not a replay from this build\n", path);
+		close();
+		return false;
+	}
+	return true;
+}
+
+void ReplayFile::close()
+{
+	if (map)
+		munmap((void *)map, length);
+	if (fd >= 0)
+		::close(fd);
+	fd = -1;
+	map = NULL;
+	head = NULL;
+	index = NULL;
+	rebuilt.clear();
+	ticks = 0;
+	nkeyframes = 0;
+	length = 0;
+}
+
+const ReplayKeyframe &ReplayFile::keyframeFor(unsigned int tick) const
+{
+	if (tick < head->firstTick)
+		tick = head->firstTick;
+	unsigned int k = (tick - head->firstTick) / REPLAY_KEYFRAME_TICKS;
+	if (k >= (unsigned int)nkeyframes)
+		k = nkeyframes - 1;
+	return index[k];
+}
+
+ReplayInput ReplayFile::input(unsigned int tick) const
+{
+	ReplayInput none = {0, 0};
+	if (tick < head->firstTick || tick >= endTick())
+		return none;
+	const ReplayKeyframe &k = keyframeFor(tick);
+	const ReplayInput *in = (const ReplayInput *)(map + k.inputOffset);
+	return in[tick - k.tick];
+}
@@ -0,0 +1,132 @@
+//Program: replay.h
+//Seekable replays for Shiba Survival
+//
+//A replay is the random seed, the keys that mattered on every physics
+//tick, and a full snapshot every REPLAY_KEYFRAME_TICKS. Playing from
+//the start needs only the keys, but to look at minute twenty the
+//player loads the keyframe at or before it and plays at most one
+//keyframe's worth of ticks on top.
+//
+//The file is laid out to be memory mapped and used in place:
+//
+//  header | block, snapshot, keys for its ticks | block, ... | index
+//
+//The index at the end has one entry per keyframe with the offsets of
+//its snapshot and key block, so finding the keyframe for a tick is a
+//division and finding the keys for a tick is one more add. Blocks are
+//padded to 8 bytes so everything can be read straight from the map.
+//
+//The index and the final header are written when the recording is
+//closed. A run can be suspended and resumed any number of times on the
+//way, the recording stays open until the game ends. Everything up to a
+//keyframe is flushed to the file when it is taken, and each keyframe
+//starts with a small ReplayBlock header, so when a crash leaves a file
+//with no index the reader walks the blocks and rebuilds one, keeping
+//everything up to the last whole keyframe.
+//
+//A keyframe holds the state after that tick's keys were handled and
+//before its physics ran, so when playing on from one the key presses
+//for the keyframe tick itself are already in it.
+//
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+#define REPLAY_VERSION 1
+//physics ticks between keyframes, five seconds
+#define REPLAY_KEYFRAME_TICKS (5 * 60)
+
+//keys for one tick, one bit per key in the game's tables
+struct ReplayInput {
+	unsigned short held;
+	unsigned short tapped;
+};
+
+struct ReplayKeyframe {
+	//first tick played after loading the snapshot
+	uint32_t tick;
+	//key records that follow, REPLAY_KEYFRAME_TICKS except for the last
+	uint32_t inputs;
+	int64_t snapshot;
+	int64_t snapshotLength;
+	int64_t inputOffset;
+};
+
+//written in front of every keyframe's snapshot
+struct ReplayBlock {
+	uint32_t magic;
+	uint32_t tick;
+	int64_t snapshotLength;
+	uint32_t checksum;
+	uint32_t pad;
+};
+
+struct ReplayHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t snapshotVersion;
+	uint32_t keyframeTicks;
+	uint64_t seed;
+	uint32_t firstTick;
+	uint32_t ticks;
+	uint32_t keyframes;
+	uint32_t pad;
+	//where the index starts, 0 until the recording is closed
+	int64_t index;
+};
+
+class ReplayWriter {
+	private:
+		FILE *fp;
+		ReplayHeader head;
+		std::vector<ReplayKeyframe> index;
+		void pad();
+	public:
+		ReplayWriter();
+		~ReplayWriter();
+		bool open(const char *path, uint64_t seed, unsigned int firstTick);
+		bool recording() const { return fp != NULL; }
+		//true when the tick about to be recorded starts a new block
+		bool wantsKeyframe() const;
+		void keyframe(const std::vector<unsigned char> &snapshot);
+		void input(const ReplayInput &in);
+		void close();
+};
+
+class ReplayFile {
+	private:
+		int fd;
+		const unsigned char *map;
+		size_t length;
+		const ReplayHeader *head;
+		const ReplayKeyframe *index;
+		//the index rebuilt from the blocks of an unfinished recording
+		std::vector<ReplayKeyframe> rebuilt;
+		unsigned int ticks;
+		int nkeyframes;
+		bool checkIndex();
+		bool rebuildIndex();
+	public:
+		ReplayFile();
+		~ReplayFile();
+		bool open(const char *path);
+		void close();
+		uint64_t seed() const { return head->seed; }
+		unsigned int firstTick() const { return head->firstTick; }
+		//one past the last recorded tick
+		unsigned int endTick() const { return head->firstTick + ticks; }
+		int keyframes() const { return nkeyframes; }
+		const ReplayKeyframe &keyframe(int k) const { return index[k]; }
+		//the keyframe to start from to reach tick, in constant time
+		const ReplayKeyframe &keyframeFor(unsigned int tick) const;
+		const unsigned char *snapshot(const ReplayKeyframe &k) const {
+			return map + k.snapshot;
+		}
+		//keys for a recorded tick
+		ReplayInput input(unsigned int tick) const;
+};
+
+#endif
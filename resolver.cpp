@@ -0,0 +1,119 @@
+//Program: resolver.cpp
+//Background host name lookups for Shiba Survival
+//
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include "resolver.h"
+#include "log.h"
+
+Resolver resolver;
+
+static double monotonicSeconds()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+Resolver::Resolver()
+{
+	stopping = false;
+}
+
+Resolver::~Resolver()
+{
+	stop();
+}
+
+//find(): index of host in the cache, adding it if it is new. Called
+//with the lock held.
+int Resolver::find(const char *host)
+{
+	for (unsigned int i = 0; i < cache.size(); i++) {
+		if (strcmp(cache[i].host, host) == 0)
+			return i;
+	}
+	ResolverEntry e;
+	snprintf(e.host, sizeof e.host, "%s", host);
+	e.addr.s_addr = 0;
+	e.state = RESOLVE_PENDING;
+	e.expires = 0.0;
+	e.queued = false;
+	cache.push_back(e);
+	return cache.size() - 1;
+}
+
+int Resolver::lookup(const char *host, struct in_addr *addr)
+{
+	std::lock_guard<std::mutex> hold(lock);
+	int i = find(host);
+	ResolverEntry &e = cache[i];
+	if (monotonicSeconds() >= e.expires && !e.queued) {
+		if (!worker.joinable())
+			worker = std::thread(&Resolver::run, this);
+		e.queued = true;
+		queue.push_back(i);
+		wake.notify_one();
+	}
+	if (e.state == RESOLVE_OK)
+		*addr = e.addr;
+	return e.state;
+}
+
+void Resolver::prefetch(const char *host)
+{
+	struct in_addr unused;
+	lookup(host, &unused);
+}
+
+void Resolver::run()
+{
+	std::unique_lock<std::mutex> hold(lock);
+	while (1) {
+		wake.wait(hold, [this] { return stopping || !queue.empty(); });
+		if (stopping)
+			return;
+		int i = queue.front();
+		queue.erase(queue.begin());
+		char host[RESOLVE_MAX_NAME];
+		strcpy(host, cache[i].host);
+		//the slow part, without the lock so lookup() never waits on it
+		hold.unlock();
+		struct addrinfo hints, *res = NULL;
+		memset(&hints, 0, sizeof hints);
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_STREAM;
+		int err = getaddrinfo(host, NULL, &hints, &res);
+		hold.lock();
+		ResolverEntry &e = cache[i];
+		e.queued = false;
+		if (err == 0 && res) {
+			e.addr = ((struct sockaddr_in *)res->ai_addr)->sin_addr;
+			e.state = RESOLVE_OK;
+			e.expires = monotonicSeconds() + RESOLVE_TTL;
+			Log("resolver: %s is %s\n", host, inet_ntoa(e.addr));
+		} else {
+			//a stale answer beats none, keep it if we had one
+			if (e.state != RESOLVE_OK)
+				e.state = RESOLVE_FAILED;
+			e.expires = monotonicSeconds() + RESOLVE_NEGATIVE_TTL;
+			Log("resolver: %s failed: %s\n", host, gai_strerror(err));
+		}
+		if (res)
+			freeaddrinfo(res);
+	}
+}
+
+void Resolver::stop()
+{
+	{
+		std::lock_guard<std::mutex> hold(lock);
+		stopping = true;
+		wake.notify_one();
+	}
+	if (worker.joinable())
+		worker.join();
+}
@@ -0,0 +1,63 @@
+//Program: resolver.h
+//Background host name lookups for Shiba Survival
+//
+//getaddrinfo() can block for seconds when the network is slow or gone,
+//which is far too long to hold up a frame. lookup() only ever reads a
+//small cache. A name it has not seen yet is queued for a worker thread
+//and reported as pending; the caller tries again later. Answers are
+//kept for RESOLVE_TTL seconds and failures for RESOLVE_NEGATIVE_TTL, so
+//a cabinet with no network asks once every so often instead of on every
+//submission. An expired answer is still handed out while the worker
+//looks the name up again.
+//
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+
+#define RESOLVE_TTL 300.0
+#define RESOLVE_NEGATIVE_TTL 30.0
+#define RESOLVE_MAX_NAME 256
+
+enum {
+	RESOLVE_OK,
+	RESOLVE_PENDING,
+	RESOLVE_FAILED
+};
+
+struct ResolverEntry {
+	char host[RESOLVE_MAX_NAME];
+	struct in_addr addr;
+	int state;
+	//monotonic seconds after which the answer is looked up again
+	double expires;
+	bool queued;
+};
+
+class Resolver {
+	private:
+		std::mutex lock;
+		std::condition_variable wake;
+		std::thread worker;
+		std::vector<ResolverEntry> cache;
+		std::vector<int> queue;
+		bool stopping;
+		int find(const char *host);
+		void run();
+	public:
+		Resolver();
+		~Resolver();
+		//never blocks; *addr is filled in when RESOLVE_OK is returned
+		int lookup(const char *host, struct in_addr *addr);
+		//start looking a name up before it is needed
+		void prefetch(const char *host);
+		void stop();
+};
+
+extern Resolver resolver;
+
+#endif
@@ -0,0 +1,154 @@
+//Program: rng.cpp
+//Seedable random number streams for Shiba Survival
+//
+#include "rng.h"
+
+Rng rngStreams[RNG_NSTREAMS];
+static uint64_t currentSeed = 0;
+
+static uint64_t splitmix64(uint64_t *x)
+{
+	uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+static inline uint32_t rotl(uint32_t x, int k)
+{
+	return (x << k) | (x >> (32 - k));
+}
+
+Rng::Rng()
+{
+	seed(0, 0);
+}
+
+//seed(): every stream number gives an unrelated sequence for a seed
+void Rng::seed(uint64_t seed, unsigned int stream)
+{
+	uint64_t x = seed ^ ((uint64_t)(stream + 1) * 0xd1b54a32d192ed03ULL);
+	uint64_t a = splitmix64(&x);
+	uint64_t b = splitmix64(&x);
+	s[0] = (uint32_t)a;
+	s[1] = (uint32_t)(a >> 32);
+	s[2] = (uint32_t)b;
+	s[3] = (uint32_t)(b >> 32);
+	for (int i = 0; i < RNG_LANES; i++) {
+		a = splitmix64(&x);
+		b = splitmix64(&x);
+		lane[0][i] = (uint32_t)a;
+		lane[1][i] = (uint32_t)(a >> 32);
+		lane[2][i] = (uint32_t)b;
+		lane[3][i] = (uint32_t)(b >> 32);
+	}
+}
+
+uint32_t Rng::next()
+{
+	uint32_t result = rotl(s[1] * 5, 7) * 9;
+	uint32_t t = s[1] << 9;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl(s[3], 11);
+	return result;
+}
+
+//multiply and keep the high half, no division and no modulo bias to
+//speak of for the small ranges the game uses
+int Rng::below(int n)
+{
+	if (n <= 0)
+		return 0;
+	return (int)(((uint64_t)next() * (uint32_t)n) >> 32);
+}
+
+float Rng::unit()
+{
+	return (next() >> 8) * (1.0f / 16777216.0f);
+}
+
+float Rng::range(float lo, float hi)
+{
+	return lo + (hi - lo) * unit();
+}
+
+//same step as next() for every lane, written so each line is a loop
+//over the lanes the compiler can turn into vector instructions
+void Rng::nextLanes(uint32_t *out)
+{
+	uint32_t *s0 = lane[0], *s1 = lane[1], *s2 = lane[2], *s3 = lane[3];
+	uint32_t t[RNG_LANES];
+	for (int i = 0; i < RNG_LANES; i++)
+		out[i] = rotl(s1[i] * 5, 7) * 9;
+	for (int i = 0; i < RNG_LANES; i++)
+		t[i] = s1[i] << 9;
+	for (int i = 0; i < RNG_LANES; i++) {
+		s2[i] ^= s0[i];
+		s3[i] ^= s1[i];
+		s1[i] ^= s2[i];
+		s0[i] ^= s3[i];
+		s2[i] ^= t[i];
+		s3[i] = rotl(s3[i], 11);
+	}
+}
+
+void Rng::fillBelow(int *out, int count, int n)
+{
+	uint32_t block[RNG_LANES];
+	if (n <= 0)
+		n = 1;
+	for (int i = 0; i < count; i += RNG_LANES) {
+		nextLanes(block);
+		int k = count - i < RNG_LANES ? count - i : RNG_LANES;
+		for (int j = 0; j < k; j++)
+			out[i + j] = (int)(((uint64_t)block[j] * (uint32_t)n) >> 32);
+	}
+}
+
+void Rng::fillUnit(float *out, int count)
+{
+	uint32_t block[RNG_LANES];
+	for (int i = 0; i < count; i += RNG_LANES) {
+		nextLanes(block);
+		int k = count - i < RNG_LANES ? count - i : RNG_LANES;
+		for (int j = 0; j < k; j++)
+			out[i + j] = (block[j] >> 8) * (1.0f / 16777216.0f);
+	}
+}
+
+//rngSeed(): reseed every stream, a replay stores this one number
+void rngSeed(uint64_t seed)
+{
+	currentSeed = seed;
+	for (int i = 0; i < RNG_NSTREAMS; i++)
+		rngStreams[i].seed(seed, i);
+}
+
+uint64_t rngCurrentSeed()
+{
+	return currentSeed;
+}
+
+void rngSaveState(StateWriter &w)
+{
+	w.put(currentSeed);
+	w.put(rngStreams);
+}
+
+bool rngLoadState(StateReader &r)
+{
+	uint64_t seed;
+	Rng streams[RNG_NSTREAMS];
+	r.get(seed);
+	r.get(streams);
+	if (r.bad)
+		return false;
+	currentSeed = seed;
+	for (int i = 0; i < RNG_NSTREAMS; i++)
+		rngStreams[i] = streams[i];
+	return true;
+}
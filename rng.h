@@ -0,0 +1,55 @@
+//Program: rng.h
+//Seedable random number streams for Shiba Survival
+//
+//Each subsystem draws from its own xoshiro128** stream, so adding a
+//random call in one place does not shift the numbers every other part
+//of the game sees. All streams come from one 64 bit seed through
+//splitmix64, which is what a replay has to store to play back the same
+//run. The fill functions step several generators side by side over
+//plain arrays for spawning many entities at once.
+//
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+#include "snapshot.h"
+
+enum {
+	RNG_ENEMY,
+	RNG_SPAWN,
+	RNG_POWERUP,
+	RNG_BULLET,
+	RNG_SCATTER,
+	RNG_NSTREAMS
+};
+
+#define RNG_LANES 8
+
+class Rng {
+	private:
+		uint32_t s[4];
+		//bulk generators, one array per state word across the lanes
+		uint32_t lane[4][RNG_LANES];
+		void nextLanes(uint32_t *out);
+	public:
+		Rng();
+		void seed(uint64_t seed, unsigned int stream);
+		uint32_t next();
+		//uniform in [0, n)
+		int below(int n);
+		//uniform in [0, 1)
+		float unit();
+		float range(float lo, float hi);
+		void fillBelow(int *out, int count, int n);
+		void fillUnit(float *out, int count);
+};
+
+extern Rng rngStreams[RNG_NSTREAMS];
+
+void rngSeed(uint64_t seed);
+uint64_t rngCurrentSeed();
+//the seed and where every stream is up to
+void rngSaveState(StateWriter &w);
+bool rngLoadState(StateReader &r);
+
+#endif
@@ -0,0 +1,141 @@
+//Program: scheduler.cpp
+//Frame pacing for Shiba Survival
+//
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/select.h>
+#include "scheduler.h"
+#include "log.h"
+
+//frames per second allowed on each screen, 0 means only vsync limits it
+static const int frameCap[FRAME_NSCREENS] = { 30, 60, 30, 30, 30, 30 };
+static const char *screenName[FRAME_NSCREENS] = {
+	"menu", "gameplay", "how to play", "credits", "high scores", "game over"
+};
+
+//package energy counter, only readable on some machines
+#define RAPL_ENERGY "/sys/class/powercap/intel-rapl:0/energy_uj"
+
+FrameScheduler frameScheduler;
+
+static double tsDiff(struct timespec *start, struct timespec *end)
+{
+	return (double)(end->tv_sec - start->tv_sec) +
+		(double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static long long readEnergy()
+{
+	long long uj = -1;
+	FILE *fp = fopen(RAPL_ENERGY, "r");
+	if (fp) {
+		if (fscanf(fp, "%lld", &uj) != 1)
+			uj = -1;
+		fclose(fp);
+	}
+	return uj;
+}
+
+FrameScheduler::FrameScheduler()
+{
+	screen = FRAME_MENU;
+	memset(wall, 0, sizeof wall);
+	memset(cpu, 0, sizeof cpu);
+	memset(energy, 0, sizeof energy);
+	memset(frames, 0, sizeof frames);
+	clock_gettime(CLOCK_MONOTONIC, &frameStart);
+	clock_gettime(CLOCK_MONOTONIC, &markWall);
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &markCpu);
+	markEnergy = readEnergy();
+}
+
+//charge the time since the last mark to the current screen
+void FrameScheduler::account()
+{
+	struct timespec w, c;
+	clock_gettime(CLOCK_MONOTONIC, &w);
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &c);
+	wall[screen] += tsDiff(&markWall, &w);
+	cpu[screen] += tsDiff(&markCpu, &c);
+	markWall = w;
+	markCpu = c;
+	if (markEnergy >= 0) {
+		long long e = readEnergy();
+		if (e >= markEnergy)
+			energy[screen] += (e - markEnergy) / 1e6;
+		markEnergy = e;
+	}
+}
+
+void FrameScheduler::setScreen(int s)
+{
+	if (s == screen)
+		return;
+	account();
+	screen = s;
+}
+
+//block until either fd is readable or timeout seconds pass, a negative
+//timeout waits forever and fd2 may be -1
+bool FrameScheduler::waitForEvents(int fd, int fd2, double timeout)
+{
+	fd_set rfds;
+	struct timeval tv, *tvp = NULL;
+	if (timeout >= 0.0) {
+		tv.tv_sec = (long)timeout;
+		tv.tv_usec = (long)((timeout - tv.tv_sec) * 1e6);
+		tvp = &tv;
+	}
+	int nfds = (fd > fd2 ? fd : fd2) + 1;
+	int ret;
+	do {
+		FD_ZERO(&rfds);
+		FD_SET(fd, &rfds);
+		if (fd2 >= 0)
+			FD_SET(fd2, &rfds);
+		ret = select(nfds, &rfds, NULL, NULL, tvp);
+	} while (ret < 0 && errno == EINTR);
+	return ret > 0;
+}
+
+void FrameScheduler::beginFrame()
+{
+	clock_gettime(CLOCK_MONOTONIC, &frameStart);
+}
+
+//sleep off whatever is left of this screen's frame budget
+void FrameScheduler::endFrame()
+{
+	frames[screen]++;
+	if (frameCap[screen] <= 0)
+		return;
+	struct timespec deadline = frameStart;
+	deadline.tv_nsec += 1000000000L / frameCap[screen];
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL)
+		== EINTR)
+		;
+}
+
+void FrameScheduler::report()
+{
+	account();
+	Log("frame scheduler: per screen usage\n");
+	Log("%-12s %8s %9s %9s %6s %10s\n",
+		"screen", "frames", "wall s", "cpu s", "cpu %", "energy J");
+	for (int i = 0; i < FRAME_NSCREENS; i++) {
+		if (wall[i] <= 0.0)
+			continue;
+		char joules[32] = "n/a";
+		if (markEnergy >= 0)
+			snprintf(joules, sizeof joules, "%.2f", energy[i]);
+		Log("%-12s %8ld %9.2f %9.2f %6.1f %10s\n", screenName[i], frames[i],
+			wall[i], cpu[i], 100.0 * cpu[i] / wall[i], joules);
+	}
+	if (markEnergy >= 0)
+		Log("energy is the whole CPU package as reported by RAPL\n");
+}
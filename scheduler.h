@@ -0,0 +1,47 @@
+//Program: scheduler.h
+//Frame pacing for Shiba Survival
+//
+//The game loop tells the scheduler which screen it is on. Screens that
+//are not animating block on the X connection until an event arrives,
+//animating screens are capped to a per screen frame rate, and the time
+//and CPU spent on each screen is tallied so the savings can be measured.
+//
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <time.h>
+
+enum {
+	FRAME_MENU,
+	FRAME_GAME,
+	FRAME_HOWTO,
+	FRAME_CREDITS,
+	FRAME_SCORES,
+	FRAME_GAMEOVER,
+	FRAME_NSCREENS
+};
+
+class FrameScheduler {
+	private:
+		int screen;
+		struct timespec frameStart;
+		struct timespec markWall;
+		struct timespec markCpu;
+		long long markEnergy;
+		double wall[FRAME_NSCREENS];
+		double cpu[FRAME_NSCREENS];
+		double energy[FRAME_NSCREENS];
+		long frames[FRAME_NSCREENS];
+		void account();
+	public:
+		FrameScheduler();
+		void setScreen(int);
+		bool waitForEvents(int fd, int fd2, double timeout);
+		void beginFrame();
+		void endFrame();
+		void report();
+};
+
+extern FrameScheduler frameScheduler;
+
+#endif
@@ -0,0 +1,600 @@
+//Program: scoreserver.cpp
+//Local leaderboard server for Shiba Survival
+//
+//Stands in for save_scores.php. It takes the same request the game
+//sends,
+//	GET /<any path>?user=<name>&score=<n>
+//over TLS, and appends "name,score" to leaderboard.csv. Everything runs
+//on one thread around one epoll set with every socket non-blocking, so
+//thousands of cabinets can post at once without a thread each. Scores
+//that arrive in the same pass of the loop go to the file in one write()
+//on an O_APPEND descriptor, so lines are never interleaved.
+//
+//Without -c and -k it makes a throwaway self-signed certificate, which
+//is enough since the game does not check certificates. Point the game
+//at it with SHIBA_SCORE_HOST=127.0.0.1 SHIBA_SCORE_PORT=<port>.
+//
+//The game appends every score to its own scores.csv before posting it,
+//so the server keeps a separate file. Run from the game directory with
+//-f scores.csv, each local score would be stored twice.
+//
+//--load runs the other side: that many clients post a score at the
+//same time, round after round, and the submissions per second and any
+//failures are printed.
+//
+//usage: ./scoreserver [-p port] [-f leaderboard.csv] [-c cert.pem -k key.pem]
+//       ./scoreserver --load host port clients [rounds]
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <time.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <string>
+#include <vector>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/x509.h>
+
+#define SERVER_PORT 4433
+#define SERVER_MAX_EVENTS 1024
+//a request line longer than this is not one of ours
+#define CONN_BUF 2048
+#define CONN_TIMEOUT 10.0
+#define MAX_NAME 32
+
+enum {
+	CONN_HANDSHAKE,
+	CONN_READ,
+	CONN_WRITE,
+	CONN_DONE
+};
+
+struct Conn {
+	int fd;
+	SSL *ssl;
+	int state;
+	char buf[CONN_BUF];
+	int len;
+	const char *reply;
+	int replyLen;
+	int sent;
+	double started;
+};
+
+static const char okReply[] =
+	"HTTP/1.1 200 OK\r\nContent-Length: 3\r\nConnection: close\r\n\r\nok\n";
+static const char badReply[] =
+	"HTTP/1.1 400 Bad Request\r\nContent-Length: 4\r\nConnection: close\r\n\r\nbad\n";
+
+static double now()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void setNonBlocking(int fd)
+{
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+//as many descriptors as we are allowed, one per connection
+static void raiseFileLimit()
+{
+	struct rlimit r;
+	if (getrlimit(RLIMIT_NOFILE, &r) == 0 && r.rlim_cur < r.rlim_max) {
+		r.rlim_cur = r.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &r);
+	}
+}
+
+//=============================================================
+// Server
+//=============================================================
+
+static bool makeSelfSigned(SSL_CTX *ctx)
+{
+	EVP_PKEY *key = EVP_EC_gen("prime256v1");
+	if (!key)
+		return false;
+	X509 *cert = X509_new();
+	ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+	X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+	X509_gmtime_adj(X509_getm_notAfter(cert), 365L * 24 * 3600);
+	X509_set_pubkey(cert, key);
+	X509_NAME *name = X509_get_subject_name(cert);
+	X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+		(const unsigned char *)"localhost", -1, -1, 0);
+	X509_set_issuer_name(cert, name);
+	bool ok = X509_sign(cert, key, EVP_sha256()) > 0 &&
+		SSL_CTX_use_certificate(ctx, cert) == 1 &&
+		SSL_CTX_use_PrivateKey(ctx, key) == 1;
+	X509_free(cert);
+	EVP_PKEY_free(key);
+	return ok;
+}
+
+static int hexValue(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+//urlDecode(): %xx and + in place, returns false on a bad escape
+static bool urlDecode(char *s)
+{
+	char *out = s;
+	for (; *s; s++) {
+		if (*s == '+') {
+			*out++ = ' ';
+		} else if (*s == '%') {
+			int hi = hexValue(s[1]);
+			int lo = hi < 0 ? -1 : hexValue(s[2]);
+			if (lo < 0)
+				return false;
+			*out++ = (char)(hi * 16 + lo);
+			s += 2;
+		} else {
+			*out++ = *s;
+		}
+	}
+	*out = '\0';
+	return true;
+}
+
+//parseScore(): pulls user and score out of the request line. The name
+//ends up in the store, so it may not hold a comma or a line break.
+static bool parseScore(char *request, char *user, int *score)
+{
+	if (strncmp(request, "GET /", 5) != 0)
+		return false;
+	char *end = strpbrk(request + 4, " \r\n");
+	if (!end)
+		return false;
+	*end = '\0';
+	char *query = strchr(request, '?');
+	if (!query)
+		return false;
+	bool haveUser = false, haveScore = false;
+	char *save;
+	for (char *p = strtok_r(query + 1, "&", &save); p; p = strtok_r(NULL, "&", &save)) {
+		char *eq = strchr(p, '=');
+		if (!eq)
+			continue;
+		*eq = '\0';
+		char *value = eq + 1;
+		if (!urlDecode(value))
+			return false;
+		if (strcmp(p, "user") == 0) {
+			int n = strlen(value);
+			if (n < 1 || n > MAX_NAME || strpbrk(value, ",\r\n"))
+				return false;
+			strcpy(user, value);
+			haveUser = true;
+		} else if (strcmp(p, "score") == 0) {
+			char *stop;
+			long v = strtol(value, &stop, 10);
+			if (stop == value || *stop || v < 0 || v > 2000000000L)
+				return false;
+			*score = (int)v;
+			haveScore = true;
+		}
+	}
+	return haveUser && haveScore;
+}
+
+class ScoreServer {
+	private:
+		SSL_CTX *ctx;
+		int listenFd;
+		int epollFd;
+		int storeFd;
+		std::vector<Conn *> conns;
+		std::string pending;
+		long accepted;
+		long stored;
+		long rejected;
+		void acceptAll();
+		void step(Conn *c);
+		void finish(Conn *c);
+		void request(Conn *c);
+		void flushScores();
+		void sweep(double t);
+	public:
+		ScoreServer();
+		bool start(int port, const char *store, const char *cert, const char *key);
+		void run();
+};
+
+ScoreServer::ScoreServer()
+{
+	ctx = NULL;
+	listenFd = epollFd = storeFd = -1;
+	accepted = stored = rejected = 0;
+}
+
+bool ScoreServer::start(int port, const char *store, const char *cert, const char *key)
+{
+	ctx = SSL_CTX_new(TLS_server_method());
+	if (cert && key) {
+		if (SSL_CTX_use_certificate_chain_file(ctx, cert) != 1 ||
+				SSL_CTX_use_PrivateKey_file(ctx, key, SSL_FILETYPE_PEM) != 1) {
+			ERR_print_errors_fp(stderr);
+			return false;
+		}
+	} else if (!makeSelfSigned(ctx)) {
+		fprintf(stderr, "scoreserver: could not make a certificate\n");
+		return false;
+	}
+	storeFd = open(store, O_WRONLY | O_APPEND | O_CREAT, 0644);
+	if (storeFd < 0) {
+		perror(store);
+		return false;
+	}
+	listenFd = socket(AF_INET, SOCK_STREAM, 0);
+	int on = 1;
+	setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on);
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof addr);
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (bind(listenFd, (struct sockaddr *)&addr, sizeof addr) < 0 ||
+			listen(listenFd, SOMAXCONN) < 0) {
+		perror("scoreserver: bind");
+		return false;
+	}
+	setNonBlocking(listenFd);
+	epollFd = epoll_create1(0);
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+	printf("scoreserver: port %d, storing to %s\n", port, store);
+	return true;
+}
+
+void ScoreServer::acceptAll()
+{
+	for (;;) {
+		int fd = accept(listenFd, NULL, NULL);
+		if (fd < 0)
+			return;
+		setNonBlocking(fd);
+		Conn *c = new Conn;
+		c->fd = fd;
+		c->ssl = SSL_new(ctx);
+		SSL_set_fd(c->ssl, fd);
+		SSL_set_accept_state(c->ssl);
+		c->state = CONN_HANDSHAKE;
+		c->len = 0;
+		c->buf[0] = '\0';
+		c->reply = NULL;
+		c->replyLen = c->sent = 0;
+		c->started = now();
+		if ((int)conns.size() <= fd)
+			conns.resize(fd + 1, NULL);
+		conns[fd] = c;
+		//edge triggered, step() always runs until OpenSSL wants more
+		struct epoll_event ev;
+		ev.events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP;
+		ev.data.ptr = c;
+		epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+		accepted++;
+		step(c);
+	}
+}
+
+void ScoreServer::request(Conn *c)
+{
+	char user[MAX_NAME + 1];
+	int score;
+	c->buf[c->len] = '\0';
+	if (parseScore(c->buf, user, &score)) {
+		char line[MAX_NAME + 16];
+		snprintf(line, sizeof line, "%s,%d\n", user, score);
+		pending += line;
+		stored++;
+		c->reply = okReply;
+		c->replyLen = sizeof okReply - 1;
+	} else {
+		rejected++;
+		c->reply = badReply;
+		c->replyLen = sizeof badReply - 1;
+	}
+	c->sent = 0;
+	c->state = CONN_WRITE;
+}
+
+//step(): moves one connection on as far as it can without blocking
+void ScoreServer::step(Conn *c)
+{
+	while (c->state != CONN_DONE) {
+		int r, err;
+		if (c->state == CONN_HANDSHAKE) {
+			r = SSL_do_handshake(c->ssl);
+			if (r == 1) {
+				c->state = CONN_READ;
+				continue;
+			}
+		} else if (c->state == CONN_READ) {
+			r = SSL_read(c->ssl, c->buf + c->len, CONN_BUF - 1 - c->len);
+			if (r > 0) {
+				c->len += r;
+				c->buf[c->len] = '\0';
+				//the whole header, or at least the request line
+				//if the client stops short of the blank line
+				if (strstr(c->buf, "\r\n\r\n") || c->len >= CONN_BUF - 1)
+					request(c);
+				continue;
+			}
+			err = SSL_get_error(c->ssl, r);
+			if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
+				return;
+			//the game hangs up right after sending without waiting for
+			//a reply, so a whole request line before the close counts
+			if (strchr(c->buf, '\n'))
+				request(c);
+			c->state = CONN_DONE;
+			break;
+		} else {
+			r = SSL_write(c->ssl, c->reply + c->sent, c->replyLen - c->sent);
+			if (r > 0) {
+				c->sent += r;
+				if (c->sent == c->replyLen) {
+					SSL_shutdown(c->ssl);
+					c->state = CONN_DONE;
+				}
+				continue;
+			}
+		}
+		err = SSL_get_error(c->ssl, r);
+		if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
+			return;
+		c->state = CONN_DONE;
+	}
+	finish(c);
+}
+
+void ScoreServer::finish(Conn *c)
+{
+	epoll_ctl(epollFd, EPOLL_CTL_DEL, c->fd, NULL);
+	SSL_free(c->ssl);
+	close(c->fd);
+	conns[c->fd] = NULL;
+	delete c;
+}
+
+void ScoreServer::flushScores()
+{
+	const char *p = pending.data();
+	size_t left = pending.size();
+	while (left > 0) {
+		ssize_t n = write(storeFd, p, left);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("scoreserver: write");
+			break;
+		}
+		p += n;
+		left -= n;
+	}
+	pending.clear();
+}
+
+//sweep(): drops connections that have been open too long
+void ScoreServer::sweep(double t)
+{
+	for (unsigned int i = 0; i < conns.size(); i++) {
+		if (conns[i] && t - conns[i]->started > CONN_TIMEOUT)
+			finish(conns[i]);
+	}
+}
+
+void ScoreServer::run()
+{
+	struct epoll_event events[SERVER_MAX_EVENTS];
+	double lastSweep = now(), lastReport = now();
+	long lastStored = 0;
+	for (;;) {
+		int n = epoll_wait(epollFd, events, SERVER_MAX_EVENTS, 1000);
+		for (int i = 0; i < n; i++) {
+			Conn *c = (Conn *)events[i].data.ptr;
+			if (!c)
+				acceptAll();
+			else if (conns[c->fd] == c)
+				step(c);
+		}
+		if (!pending.empty())
+			flushScores();
+		double t = now();
+		if (t - lastSweep > 1.0) {
+			sweep(t);
+			lastSweep = t;
+		}
+		if (t - lastReport > 10.0) {
+			if (stored != lastStored)
+				printf("scoreserver: %ld connections, %ld stored, %ld rejected\n",
+					accepted, stored, rejected);
+			lastStored = stored;
+			lastReport = t;
+		}
+	}
+}
+
+//=============================================================
+// Load generator
+//=============================================================
+
+//loadRound(): clients connections all post a score at once, returns
+//how many got a 200 back
+static int loadRound(SSL_CTX *ctx, struct sockaddr_in *addr, int clients, int round)
+{
+	int ep = epoll_create1(0);
+	std::vector<Conn> c(clients);
+	int open = 0, ok = 0;
+	for (int i = 0; i < clients; i++) {
+		c[i].fd = socket(AF_INET, SOCK_STREAM, 0);
+		c[i].state = CONN_DONE;
+		if (c[i].fd < 0)
+			continue;
+		setNonBlocking(c[i].fd);
+		if (connect(c[i].fd, (struct sockaddr *)addr, sizeof *addr) < 0 &&
+				errno != EINPROGRESS) {
+			close(c[i].fd);
+			continue;
+		}
+		c[i].ssl = SSL_new(ctx);
+		SSL_set_fd(c[i].ssl, c[i].fd);
+		SSL_set_connect_state(c[i].ssl);
+		c[i].state = CONN_HANDSHAKE;
+		c[i].len = snprintf(c[i].buf, CONN_BUF,
+			"GET /save_scores.php?user=load%d&score=%d HTTP/1.1\r\n"
+			"User-Agent: scoreserver\r\nHost: localhost\r\n\r\n", i, round * 1000 + i);
+		c[i].sent = 0;
+		struct epoll_event ev;
+		ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+		ev.data.u32 = i;
+		epoll_ctl(ep, EPOLL_CTL_ADD, c[i].fd, &ev);
+		open++;
+	}
+	struct epoll_event events[SERVER_MAX_EVENTS];
+	double deadline = now() + CONN_TIMEOUT;
+	while (open > 0 && now() < deadline) {
+		int n = epoll_wait(ep, events, SERVER_MAX_EVENTS, 100);
+		for (int e = 0; e < n; e++) {
+			Conn &k = c[events[e].data.u32];
+			while (k.state != CONN_DONE) {
+				int r;
+				if (k.state == CONN_HANDSHAKE) {
+					r = SSL_do_handshake(k.ssl);
+					if (r == 1) {
+						k.state = CONN_WRITE;
+						continue;
+					}
+				} else if (k.state == CONN_WRITE) {
+					r = SSL_write(k.ssl, k.buf + k.sent, k.len - k.sent);
+					if (r > 0) {
+						k.sent += r;
+						if (k.sent == k.len) {
+							k.state = CONN_READ;
+							k.len = 0;
+						}
+						continue;
+					}
+				} else {
+					r = SSL_read(k.ssl, k.buf + k.len, CONN_BUF - 1 - k.len);
+					if (r > 0) {
+						k.len += r;
+						continue;
+					}
+					if (SSL_get_error(k.ssl, r) == SSL_ERROR_ZERO_RETURN || r == 0) {
+						k.buf[k.len] = '\0';
+						ok += strncmp(k.buf, "HTTP/1.1 200", 12) == 0;
+						k.state = CONN_DONE;
+						break;
+					}
+				}
+				int err = SSL_get_error(k.ssl, r);
+				if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
+					break;
+				//the server may close before our close_notify read
+				k.buf[k.len] = '\0';
+				ok += k.len > 0 && strncmp(k.buf, "HTTP/1.1 200", 12) == 0;
+				k.state = CONN_DONE;
+			}
+			if (k.state == CONN_DONE && k.ssl) {
+				SSL_free(k.ssl);
+				k.ssl = NULL;
+				close(k.fd);
+				open--;
+			}
+		}
+	}
+	for (int i = 0; i < clients; i++) {
+		if (c[i].state != CONN_DONE && c[i].ssl) {
+			SSL_free(c[i].ssl);
+			close(c[i].fd);
+		}
+	}
+	close(ep);
+	return ok;
+}
+
+static int loadTest(const char *host, int port, int clients, int rounds)
+{
+	struct addrinfo hints, *res;
+	memset(&hints, 0, sizeof hints);
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	if (getaddrinfo(host, NULL, &hints, &res) != 0) {
+		fprintf(stderr, "scoreserver: cannot resolve %s\n", host);
+		return 1;
+	}
+	struct sockaddr_in addr = *(struct sockaddr_in *)res->ai_addr;
+	addr.sin_port = htons(port);
+	freeaddrinfo(res);
+	SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+	long total = 0, good = 0;
+	double t0 = now();
+	for (int r = 0; r < rounds; r++) {
+		double t = now();
+		int ok = loadRound(ctx, &addr, clients, r);
+		printf("round %d: %d of %d stored in %.3f s\n", r, ok, clients, now() - t);
+		total += clients;
+		good += ok;
+	}
+	double seconds = now() - t0;
+	printf("%ld of %ld submissions stored, %.0f per second\n", good, total,
+		good / seconds);
+	SSL_CTX_free(ctx);
+	return good == total ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+	signal(SIGPIPE, SIG_IGN);
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	raiseFileLimit();
+	if (argc > 1 && strcmp(argv[1], "--load") == 0) {
+		if (argc < 5) {
+			fprintf(stderr, "usage: %s --load host port clients [rounds]\n", argv[0]);
+			return 1;
+		}
+		return loadTest(argv[2], atoi(argv[3]), atoi(argv[4]),
+			argc > 5 ? atoi(argv[5]) : 1);
+	}
+	int port = SERVER_PORT;
+	const char *store = "leaderboard.csv";
+	const char *cert = NULL, *key = NULL;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "-p") == 0)
+			port = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-f") == 0)
+			store = argv[i + 1];
+		else if (strcmp(argv[i], "-c") == 0)
+			cert = argv[i + 1];
+		else if (strcmp(argv[i], "-k") == 0)
+			key = argv[i + 1];
+	}
+	ScoreServer server;
+	if (!server.start(port, store, cert, key))
+		return 1;
+	server.run();
+	return 0;
+}
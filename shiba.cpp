@@ -11,6 +11,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <unistd.h>
+#include <sys/socket.h>
 #include <ctime>
 #include <cmath>
 #include <X11/Xlib.h>
@@ -27,6 +28,23 @@
 #include "fonts.h"
 #include "log.h"
 #include "danL.h"
+#include "text.h"
+#include "scheduler.h"
+#include "input.h"
+#include "jobs.h"
+#include "bullets.h"
+#include "rng.h"
+#include "waves.h"
+#include "stress.h"
+#include "arena.h"
+#include "alloctrack.h"
+#include "soak.h"
+#include "resolver.h"
+#include "spectate.h"
+#include "snapshot.h"
+#include "replay.h"
+#include "assets.h"
+#include "timingwheel.h"
 
 //defined types
 typedef float Flt;
@@ -34,8 +52,6 @@ typedef float Vec[3];
 typedef Flt	Matrix[4][4];
 
 //macros
-#define rnd() (((Flt)rand())/(Flt)RAND_MAX)
-#define random(a) (rand()%a)
 #define VecZero(v) (v)[0]=0.0,(v)[1]=0.0,(v)[2]=0.0
 #define MakeVector(x, y, z, v) (v)[0]=(x),(v)[1]=(y),(v)[2]=(z)
 #define VecCopy(a,b) (b)[0]=(a)[0];(b)[1]=(a)[1];(b)[2]=(a)[2]
@@ -48,7 +64,6 @@ const float timeslice = 1.0f;
 const float gravity = -0.2f;
 #define PI 3.141592653589793
 #define ALPHA 1
-const int MAX_BULLETS = 11;
 const Flt MINIMUM_ASTEROID_SIZE = 60.0;
 
 //-----------------------------------------------------------------------------
@@ -58,6 +73,7 @@ const double oobillion = 1.0 / 1e9;
 extern struct timespec timeStart, timeCurrent;
 extern struct timespec timePause;
 extern double physicsCountdown;
+extern unsigned int physicsTick;
 extern double timeSpan;
 extern double timeDiff(struct timespec *start, struct timespec *end);
 extern void timeCopy(struct timespec *dest, struct timespec *source);
@@ -66,7 +82,6 @@ extern void timeCopy(struct timespec *dest, struct timespec *source);
 class Global {
 public:
 	int xres, yres;
-	char keys[65536];
 	float finalScore;
 	bool showCredits;
 	bool gameMenu;
@@ -76,12 +91,15 @@ public:
 	bool gameScores;
 	bool howTo;
 	bool sentScore;
+	bool latencyProbe;
+	//drawing someone else's game from the spectator stream
+	bool spectating;
 	char *user;
 	AmbersGlobals *ag;
 	//float score;
 	
 	GLuint textures[9];
-	GLuint enemySprites[3];
+	GLuint enemySprites[numEnemyImages];
 	static Global *instance;
 	static Global *getInstance() {
 		if (!instance) {
@@ -92,7 +110,6 @@ public:
 	Global() {
 		xres = 1366;
 		yres = 768;
-		memset(keys, 0, 65536);
 		finalScore = 0.0;
 		gameMenu = true;
 		gameOver = false;
@@ -100,6 +117,8 @@ public:
 		gameStart = false;
 		gameScores = false;
 		howTo = false;
+		latencyProbe = false;
+		spectating = false;
 		//sentScore = false;
 		ag = ag->getInstance();
 		//score = 0;
@@ -130,17 +149,6 @@ public:
 	}
 };
 
-//keep?
-class Bullet {
-public:
-	Vec pos;
-	Vec vel;
-	float color[3];
-	struct timespec time;
-public:
-	Bullet() { }
-};
-
 /*
 	Different enemies:
 	- Cats
@@ -152,24 +160,18 @@ public:
 class Game {
 public:
 	Shiba shiba;
-	Bullet *barr;
-	int nbullets;
-	struct timespec bulletTimer;
-	struct timespec mouseThrustTimer;
-	bool mouseThrustOn;
-public:
-	Game() {
-		
-		barr = new Bullet[MAX_BULLETS];
-		nbullets = 0;
-		mouseThrustOn = false;
-		clock_gettime(CLOCK_REALTIME, &bulletTimer);
-	}
-	~Game() {
-		delete [] barr;
-	}
 } g;
 
+//the last suspend or checkpoint, empty when there is nothing to resume
+static std::vector<unsigned char> savedGame;
+//SHIBA_RECORD=file records every game played to file
+static const char *recordPath = NULL;
+static ReplayWriter recorder;
+static std::vector<unsigned char> keyframeScratch;
+//textures each screen draws, and the screen that holds them now
+static std::vector<int> screenAssets[FRAME_NSCREENS];
+static int assetScreen = -1;
+
 Image img[9] = {
 	Image("./images/amberZ.png"),
 	Image("./images/josephS.png"),
@@ -188,6 +190,8 @@ private:
 	Display *dpy;
 	Window win;
 	GLXContext glc;
+	bool focused;
+	bool mapped;
 public:
 	X11_wrapper() { }
 	X11_wrapper(int w, int h) {
@@ -223,9 +227,10 @@ public:
 		} 
 		Colormap cmap = XCreateColormap(dpy, root, vi->visual, AllocNone);
 		swa.colormap = cmap;
-		swa.event_mask = ExposureMask | KeyPressMask | KeyReleaseMask |
+		//keys are read by the input thread on its own connection
+		swa.event_mask = ExposureMask |
 			PointerMotionMask | MotionNotify | ButtonPress | ButtonRelease |
-			StructureNotifyMask | SubstructureNotifyMask;
+			StructureNotifyMask | SubstructureNotifyMask | FocusChangeMask;
 		unsigned int winops = CWBorderPixel|CWColormap|CWEventMask;
 		if (fullscreen) {
 			winops |= CWOverrideRedirect;
@@ -238,7 +243,9 @@ public:
 		set_title();
 		glc = glXCreateContext(dpy, vi, NULL, GL_TRUE);
 		glXMakeCurrent(dpy, win, glc);
+		set_swap_interval(1);
 		show_mouse_cursor(0);
+		focused = mapped = true;
 	}
 	~X11_wrapper() {
 		XDestroyWindow(dpy, win);
@@ -276,6 +283,49 @@ public:
 	void swapBuffers() {
 		glXSwapBuffers(dpy, win);
 	}
+	void set_swap_interval(int interval) {
+		//Sync buffer swaps to the display refresh if the driver lets us.
+		typedef void (*SwapIntervalEXT)(Display *, GLXDrawable, int);
+		typedef int (*SwapIntervalMESA)(unsigned int);
+		typedef int (*SwapIntervalSGI)(int);
+		const char *ext = glXQueryExtensionsString(dpy, DefaultScreen(dpy));
+		if (ext == NULL)
+			return;
+		if (strstr(ext, "GLX_EXT_swap_control")) {
+			SwapIntervalEXT f = (SwapIntervalEXT)glXGetProcAddressARB(
+				(const GLubyte *)"glXSwapIntervalEXT");
+			if (f)
+				f(dpy, win, interval);
+		} else if (strstr(ext, "GLX_MESA_swap_control")) {
+			SwapIntervalMESA f = (SwapIntervalMESA)glXGetProcAddressARB(
+				(const GLubyte *)"glXSwapIntervalMESA");
+			if (f)
+				f(interval);
+		} else if (strstr(ext, "GLX_SGI_swap_control")) {
+			SwapIntervalSGI f = (SwapIntervalSGI)glXGetProcAddressARB(
+				(const GLubyte *)"glXSwapIntervalSGI");
+			if (f)
+				f(interval);
+		}
+	}
+	void check_focus(XEvent *e) {
+		//Track whether the window can be seen and has the keyboard.
+		switch (e->type) {
+			case FocusIn:   focused = true;  break;
+			case FocusOut:  focused = false; break;
+			case MapNotify: mapped = true;   break;
+			case UnmapNotify: mapped = false; break;
+		}
+	}
+	bool isActive() {
+		return focused && mapped;
+	}
+	int getConnection() {
+		return ConnectionNumber(dpy);
+	}
+	Window getWindow() {
+		return win;
+	}
 	bool getXPending() {
 		return XPending(dpy);
 	}
@@ -314,17 +364,45 @@ public:
 } x11(gl->xres, gl->yres);
 
 //function prototypes
-unsigned char *buildAlphaData(Image *img);
 void init_opengl(void);
 //int check_mouse(XEvent *e);
-int check_keys(XEvent *e);
+int check_keys(int key);
+int consumeInput(int *done);
 void physics();
 void physicsKeyEvents();
 void shibaControl();
 void bulletPositionControl();
 void shootBullet();
 void render();
+#ifdef DEBUG
+int allocCheck(int);
+#define ALLOC_CHECK_TICKS 3600
+//frames of each menu screen it checks after them
+#define ALLOC_CHECK_FRAMES 60
+#endif
+int currentScreen();
+void showScreenAssets(int);
 void gameplayScreen();
+void endGame();
+void newGame();
+int soakTest(double);
+SpectateHeader spectateHeader();
+bool saveGame(std::vector<unsigned char> &);
+bool loadGame(const unsigned char *, int);
+void resetGame();
+ReplayInput replayInput();
+void applyReplayInput(const ReplayInput &, bool);
+void startRecording();
+bool playFrom(const ReplayFile &, const ReplayKeyframe &, unsigned int);
+bool seekReplay(const ReplayFile &, unsigned int);
+unsigned int simulationHash();
+int playReplay(const char *, double);
+int checkReplay(const char *);
+void suspendGame();
+void resumeGame();
+void checkpointGame();
+int watchGame(const char *, int);
+int spectateTest(int);
 void drawBullet();
 void drawCredits();
 //void updateFrame();
@@ -338,91 +416,236 @@ int main(int argc, char *argv[])
 {
 	logOpen();
 
+	//./shiba --bench-jobs times the enemy update on 1..N worker threads
+	if (argc > 1 && strcmp(argv[1], "--bench-jobs") == 0) {
+		enemyScalingBenchmark();
+		logClose();
+		return 0;
+	}
+
+	//./shiba --watch host [port] draws a game streamed by another shiba
+	const char *watchHost = NULL;
+	int watchPort = SPECTATE_PORT;
+	if (argc > 2 && strcmp(argv[1], "--watch") == 0) {
+		watchHost = argv[2];
+		if (argc > 3)
+			watchPort = atoi(argv[3]);
+		argc = 1;
+	}
+	//./shiba --spectate-test [ticks] streams a bot game over loopback
+	int spectateTicks = 0;
+	if (argc > 1 && strcmp(argv[1], "--spectate-test") == 0) {
+		spectateTicks = (argc > 2) ? atoi(argv[2]) : SPECTATE_TEST_TICKS;
+		argc = 1;
+	}
+	//./shiba --replay file [seconds] plays a recording from any point,
+	//./shiba --replay-check file checks it plays back the same
+	const char *replayPath = NULL;
+	double replayStart = 0.0;
+	bool replayCheck = false;
+	if (argc > 2 && (strcmp(argv[1], "--replay") == 0 ||
+			strcmp(argv[1], "--replay-check") == 0)) {
+		replayCheck = strcmp(argv[1], "--replay-check") == 0;
+		replayPath = argv[2];
+		if (argc > 3)
+			replayStart = atof(argv[3]);
+		argc = 1;
+	}
+	//./shiba --stress [budget_ms] finds how many entities fit in a frame
+	double stressBudget = 0.0;
+	//./shiba --soak [minutes] plays games back to back and reports growth
+	double soakMinutes = 0.0;
+	if (argc > 1 && strcmp(argv[1], "--soak") == 0) {
+		soakMinutes = (argc > 2) ? atof(argv[2]) : 60.0;
+		argc = 1;
+	}
+	#ifdef DEBUG
+	//./debug --alloc-check [ticks] fails if a replayed tick or frame allocates
+	int allocCheckTicks = 0;
+	if (argc > 1 && strcmp(argv[1], "--alloc-check") == 0) {
+		allocCheckTicks = (argc > 2) ? atoi(argv[2]) : ALLOC_CHECK_TICKS;
+		argc = 1;
+	}
+	#endif
+	if (argc > 1 && strcmp(argv[1], "--stress") == 0) {
+		stressBudget = (argc > 2) ? atof(argv[2]) : 1000.0 / 60.0;
+		argc = 1;
+	}
+
 	if (argc < 2) {
 		gl->user = (char *) "anonymous";
 	} else {
 		gl->user = argv[1];
 	}
 
+	//the latency harness needs the area around the shiba kept clear
+	gl->latencyProbe = (getenv("SHIBA_LATENCY_PROBE") != NULL);
+
 	init_opengl();
-	srand(time(NULL));
+	//SHIBA_SEED=n plays the same run again
+	const char *seedEnv = getenv("SHIBA_SEED");
+	rngSeed(seedEnv ? strtoull(seedEnv, NULL, 10) : (uint64_t)time(NULL));
+	Log("random seed %llu\n", (unsigned long long)rngCurrentSeed());
+	waves.load(WAVE_FILE);
 	clock_gettime(CLOCK_REALTIME, &timePause);
 	clock_gettime(CLOCK_REALTIME, &timeStart);
 	x11.set_mouse_position(100,100);
+	inputThread.start(x11.getWindow());
+	jobSystem.start(0);
 	int done = 0;
 
 	enemyGetResolution(gl->xres, gl->yres);
+	if (stressBudget > 0.0) {
+		stressBenchmark(stressBudget);
+		inputThread.stop();
+		jobSystem.stop();
+		cleanup_fonts();
+		logClose();
+		return 0;
+	}
+	if (replayPath) {
+		int failed = replayCheck ? checkReplay(replayPath) :
+			playReplay(replayPath, replayStart);
+		inputThread.stop();
+		jobSystem.stop();
+		cleanup_fonts();
+		logClose();
+		return failed;
+	}
+	if (watchHost || spectateTicks > 0) {
+		int failed = watchHost ? watchGame(watchHost, watchPort) :
+			spectateTest(spectateTicks);
+		inputThread.stop();
+		jobSystem.stop();
+		cleanup_fonts();
+		logClose();
+		return failed;
+	}
+	if (soakMinutes > 0.0) {
+		int failed = soakTest(soakMinutes);
+		inputThread.stop();
+		jobSystem.stop();
+		cleanup_fonts();
+		logClose();
+		return failed;
+	}
+	#ifdef DEBUG
+	if (allocCheckTicks > 0) {
+		int failed = allocCheck(allocCheckTicks);
+		inputThread.stop();
+		jobSystem.stop();
+		cleanup_fonts();
+		logClose();
+		return failed;
+	}
+	#endif
+	//look the score server up now, so the first game over can send at once
+	resolver.prefetch(gl->ag->scoreHost);
+	//a run that was suspended or cut short comes back on Resume
+	if (snapshotReadFile(SNAPSHOT_FILE, savedGame))
+		Log("found a saved game from %s\n", SNAPSHOT_FILE);
+	recordPath = getenv("SHIBA_RECORD");
+	//SHIBA_SPECTATE_PORT=n lets ./shiba --watch follow this game, from
+	//this machine only unless SHIBA_SPECTATE_ADDR says where to listen
+	if (getenv("SHIBA_SPECTATE_PORT"))
+		spectator.open(atoi(getenv("SHIBA_SPECTATE_PORT")),
+			getenv("SHIBA_SPECTATE_ADDR"));
 
+	bool redraw = true;
+	int lastScreen = -1;
 	while (!done) {
+		int screen = currentScreen();
+		frameScheduler.setScreen(screen);
+		if (screen != lastScreen) {
+			redraw = true;
+			lastScreen = screen;
+		}
+		bool animating = gl->gameStart && x11.isActive();
+		if (!animating && !redraw && !x11.getXPending() &&
+				inputThread.queue.empty()) {
+			//Nothing on this screen moves, so sleep until the
+			//X server or the input thread has something for us.
+			frameScheduler.waitForEvents(x11.getConnection(),
+				inputThread.getWakeFd(), -1.0);
+			inputThread.clearWake();
+			//run one tick right away so the key that woke us is handled
+			clock_gettime(CLOCK_REALTIME, &timeStart);
+			physicsCountdown = physicsRate;
+		}
+		frameScheduler.beginFrame();
+		frameArena.reset();
+		flushScoreQueue();
+		redraw = false;
 		if(gl->gameStart != 1){
 			gl->ag->gameTimer.startTimer();	
-			if (scatterShotObject.size() > 0) {
-				cleanUpShots();
-			}
+			cleanUpShots();
 		}
 		//set the number of lives and score at start of new game
 		if (gl->gameNew){
-			if (enemyController.enemies.size() > 0){
-				enemyController.cleanupEnemies();
-			}
-			numLivesLeft.currentLives = 3;
-			scoreObject.setScore(0);
-			g.shiba.pos[0] = (Flt)(gl->xres/2);
-			g.shiba.pos[1] = (Flt)(gl->yres/2);
-		
+			newGame();
 		}
 		//update timer
 		updateTimer((int) gl->ag->gameTimer.getElapsedMinutes(), ((int) gl->ag->gameTimer.getElapsedSeconds() % 60));
 		while (x11.getXPending()) {
 			XEvent e = x11.getXNextEvent();
 			x11.check_resize(&e);
+			x11.check_focus(&e);
 			//check_mouse(&e);
-			done = check_keys(&e);
+			redraw = true;
+		}
+		if (!x11.isActive()) {
+			//Pause the run while the window is unfocused or minimized.
+			gl->ag->gameTimer.pauseTimer();
+			clock_gettime(CLOCK_REALTIME, &timeStart);
+			continue;
 		}
+		gl->ag->gameTimer.resumeTimer();
 		clock_gettime(CLOCK_REALTIME, &timeCurrent);
 		timeSpan = timeDiff(&timeStart, &timeCurrent);
 		timeCopy(&timeStart, &timeCurrent);
 		physicsCountdown += timeSpan;
 		while (physicsCountdown >= physicsRate) {
-			physics();
+			if (consumeInput(&done))
+				redraw = true;
+			//suspended ticks are not recorded, a resume carries on
+			//from the tick the suspend saved
+			if (recorder.recording() && gl->gameStart) {
+				if (recorder.wantsKeyframe() && saveGame(keyframeScratch))
+					recorder.keyframe(keyframeScratch);
+				recorder.input(replayInput());
+			}
+			{
+				ALLOC_PHASE(ALLOC_PHYSICS);
+				physics();
+			}
+			if (spectator.active())
+				spectator.publish(spectateHeader());
+			if (gl->gameStart && physicsTick % SNAPSHOT_CHECKPOINT_TICKS == 0)
+				checkpointGame();
 			physicsCountdown -= physicsRate;
 		}
-		render();
+		{
+			ALLOC_PHASE(ALLOC_RENDER);
+			render();
+		}
 		x11.swapBuffers();
+		frameScheduler.endFrame();
 	}
+	recorder.close();
+	inputThread.stop();
+	jobSystem.stop();
+	resolver.stop();
+	frameScheduler.report();
+	spectator.report();
+	assets.report();
+	#ifdef DEBUG
+	allocReport();
+	#endif
 	cleanup_fonts();
 	logClose();
 	return 0;
 }
 
-unsigned char *buildAlphaData(Image *img)
-{
-	int i;
-	unsigned char *newdata, *ptr;
-	unsigned char *data = (unsigned char *)img->data;
-	newdata = (unsigned char *)malloc(img->width * img->height * 4);
-	ptr = newdata;
-	unsigned char a, b, c;
-	unsigned char t0 = *(data + 0);
-	unsigned char t1 = *(data + 1);
-	unsigned char t2 = *(data + 2);
-	for (i = 0; i < img->width * img->height * 3; i += 3)
-	{
-			a = *(data + 0);
-			b = *(data + 1);
-			c = *(data + 2);
-			*(ptr + 0) = a;
-			*(ptr + 1) = b;
-			*(ptr + 2) = c;
-			*(ptr + 3) = 1;
-			if (a == t0 && b == t1 && c == t2)
-					*(ptr + 3) = 0;
-			ptr += 4;
-			data += 3;
-	}
-	return newdata;
-}
-
 void init_opengl(void)
 {
 	//OpenGL initialization
@@ -444,47 +667,48 @@ void init_opengl(void)
 	glEnable(GL_TEXTURE_2D);
 	initialize_fonts();
 
-	unsigned char *spriteData;
-	
+	//textures are made now and loaded when a screen first needs them
+	int h[9];
 	for (int i = 0; i < 9; i++) {
-		glGenTextures(1, &gl->textures[i]);
-		glBindTexture(GL_TEXTURE_2D, gl->textures[i]);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		if (i == 5) {
-			spriteData = buildAlphaData(&img[i]);
-    	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, img[i].width, img[i].height, 0, GL_RGBA, GL_UNSIGNED_BYTE, spriteData);
-			free(spriteData);
-		}
-		else {
-			glTexImage2D(GL_TEXTURE_2D, 0, 3, img[i].width, img[i].height, 0, GL_RGB,
-			GL_UNSIGNED_BYTE, img[i].data);
-		}
+		int flags = (i == 5) ? ASSET_COLORKEY : (i == 6 || i == 7) ? ASSET_16BIT : 0;
+		h[i] = assets.add(&img[i], flags);
+		gl->textures[i] = assets.texture(h[i]);
 	}
-	
-	//int numEnemySprites = sizeof(enemyImages) / (sizeof(enemyImages[0]) - 1);
+	//gameplayScreen() only ever shows the left quarter of the grass
+	assets.crop(h[6], 0.0f, 0.0f, 0.25f, 1.0f);
+	screenAssets[FRAME_MENU].push_back(h[7]);
+	screenAssets[FRAME_GAMEOVER].push_back(h[8]);
+	for (int i = 0; i < 5; i++)
+		screenAssets[FRAME_CREDITS].push_back(h[i]);
+	screenAssets[FRAME_GAME].push_back(h[5]);
+	screenAssets[FRAME_GAME].push_back(h[6]);
 	for (int i = 0; i < numEnemyImages; i++) {
-		glGenTextures(1, &gl->enemySprites[i]);
-		glBindTexture(GL_TEXTURE_2D, gl->enemySprites[i]);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		spriteData = buildAlphaData(&enemyImages[i]);
-    	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, enemyImages[i].width, enemyImages[i].height, 0, GL_RGBA, GL_UNSIGNED_BYTE, spriteData);
-		free(spriteData);
-		//glTexImage2D(GL_TEXTURE_2D, 0, 3, enemyImages[i].width, enemyImages[i].height, 0, GL_RGB,
-		//	GL_UNSIGNED_BYTE, enemyImages[i].data);
-		
+		int e = assets.add(&enemyImages[i], ASSET_COLORKEY);
+		gl->enemySprites[i] = assets.texture(e);
 		getTexturesFunction(gl->enemySprites[i]);
+		screenAssets[FRAME_GAME].push_back(e);
 	}
-
 	for (int i = 0; i < 4; i++) {
-		glGenTextures(1,&powerUpTextures[i]);
-		glBindTexture(GL_TEXTURE_2D, powerUpTextures[i]);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		spriteData = buildAlphaData(&powerUpImage[i]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, powerUpImage[i].width, powerUpImage[i].height, 0, GL_RGBA,GL_UNSIGNED_BYTE, spriteData);
+		int p = assets.add(&powerUpImage[i], ASSET_COLORKEY);
+		powerUpTextures[i] = assets.texture(p);
+		screenAssets[FRAME_GAME].push_back(p);
 	}
+	//SHIBA_TEXTURE_MB=n keeps at most n MB of textures no screen is using
+	if (getenv("SHIBA_TEXTURE_MB"))
+		assets.setBudget(atol(getenv("SHIBA_TEXTURE_MB")) << 20);
+}
+
+//showScreenAssets(): swaps the last screen's textures for this one's,
+//loading whatever is not on the card yet
+void showScreenAssets(int screen)
+{
+	if (screen == assetScreen)
+		return;
+	//acquire first so textures both screens use are never dropped
+	assets.acquire(screenAssets[screen]);
+	if (assetScreen >= 0)
+		assets.release(screenAssets[assetScreen]);
+	assetScreen = screen;
 }
 
 void normalize2d(Vec v)
@@ -567,33 +791,31 @@ void normalize2d(Vec v)
 //	return 0;
 //}
 
-int check_keys(XEvent *e)
+//consumeInput(): apply the queued key events that happened before the
+//end of the current physics tick, returns how many were handled
+int consumeInput(int *done)
 {
-	//keyboard input?
-	static int shift=0;
-	int key = (XLookupKeysym(&e->xkey, 0) & 0x0000ffff);
-	//Log("key: %i\n", key);
-	if (e->type == KeyRelease) {
-		gl->keys[key]=0;
-		/*
-		if (key == XK_Shift_L || key == XK_Shift_R)
-			shift=0;
-		return 0;
-		*/
-	}
-	if (e->type == KeyPress) {
-		//std::cout << "press" << std::endl;
-		gl->keys[key]=1;
-		/*
-		if (key == XK_Shift_L || key == XK_Shift_R) {
-			shift=1;
-			return 0;
-		}
-		*/
-	} else {
-		return 0;
+	//the tick being run ends this many seconds before timeCurrent
+	double tickEnd = physicsCountdown - physicsRate;
+	int n = 0;
+	KeyEvent e;
+	keyState.clearEdges();
+	while (inputThread.queue.peek(e)) {
+		if (timeDiff(&e.time, &timeCurrent) < tickEnd)
+			break;
+		keyState.apply(e);
+		if (e.press)
+			*done |= check_keys(e.key);
+		inputThread.queue.pop();
+		n++;
 	}
-	if (shift){}
+	return n;
+}
+
+//check_keys(): menu and debug keys, called once for each key press
+int check_keys(int key)
+{
+	//Log("key: %i\n", key);
 	switch (key) {
 		static int i = 0;
 		case XK_c:
@@ -615,6 +837,7 @@ int check_keys(XEvent *e)
 				gl->ag->topScores = 1;
 			}
 			if (gl->gameStart) {
+				suspendGame();
 				enemyController.cleanupEnemies();
 				gl->gameMenu ^= 1;
 				gl->gameStart ^= 1;
@@ -648,6 +871,8 @@ int check_keys(XEvent *e)
 						gl->gameMenu ^= 1;
 						gl->gameStart ^= 1;
 						gl->gameNew = false;
+						resumeGame();
+						startRecording();
 						//printf("Resume was clicked!\n");
 						break;
 					case 1:
@@ -667,7 +892,7 @@ int check_keys(XEvent *e)
 						break;
 					case 4:
 						//printf("Quit was clicked\n");
-						exit(0);
+						return 1;
 				}
 			}
 			break;
@@ -707,13 +932,18 @@ int check_keys(XEvent *e)
 
 void physics()
 {
+	physicsTick++;
 	shibaControl();
 	//Update bullet positions
 	bulletPositionControl();
 	//check keys pressed now
 	physicsKeyEvents();
-	if (gl->gameStart) {
+	if (gl->gameStart && !gl->latencyProbe) {
 		powerUpPhysicsCheck(g.shiba.pos[0], g.shiba.pos[1]);
+		if (!flyingShiba) {
+			enemyController.runWaves(g.shiba.pos[0], g.shiba.pos[1]);
+			enemyController.updateAllPosition(g.shiba.pos[0], g.shiba.pos[1]);
+		}
 	}
 }
 
@@ -743,137 +973,653 @@ void shibaControl()
 
 void bulletPositionControl()
 {
-	struct timespec bt;
-	clock_gettime(CLOCK_REALTIME, &bt);
-	int i=0;
-	while (i < g.nbullets) {
-		Bullet *b = &g.barr[i];
-		//How long has bullet been alive?
-		double ts = timeDiff(&b->time, &bt);
-		if (ts > 2.5) {
-			//time to delete the bullet.
-			memcpy(&g.barr[i], &g.barr[g.nbullets-1],
-				sizeof(Bullet));
-			g.nbullets--;
-			//do not increment i.
-			continue;
-		}
-		//move the bullet
-		b->pos[0] += b->vel[0];
-		b->pos[1] += b->vel[1];
-		//Check for collision with window edges
-		if (b->pos[0] < 0.0) {
-			b->pos[0] += (float)gl->xres;
-		}
-		else if (b->pos[0] > (float)gl->xres) {
-			b->pos[0] -= (float)gl->xres;
-		}
-		else if (b->pos[1] < 0.0) {
-			b->pos[1] += (float)gl->yres;
-		}
-		else if (b->pos[1] > (float)gl->yres) {
-			b->pos[1] -= (float)gl->yres;
-		}
-
-		
-		if(enemyController.bulletHitEnemy(b->pos[0], b->pos[1])){
-			//removes bullet if hit
-			memcpy(&g.barr[i], &g.barr[g.nbullets-1],
-				sizeof(Bullet));
-			g.nbullets--;
-		}
-		
-		i++;
-	}
+	//expire, move and wrap every bullet
+	bullets.update(physicsTick, (float)gl->xres, (float)gl->yres);
+	//check every bullet against the enemies in one batch
+	enemyController.bulletHits();
 }
 
 // Don't want to confuse for checkKeys, could we combine those?
 void physicsKeyEvents()
 {
-	if (gl->keys[XK_Left]) {
+	if (keyState.isDown(XK_Left)) {
 		g.shiba.angle = 90;
 		img[5].animation = 3;
 		updateFrame(img[5], g.shiba.timer, 0.1);
 		g.shiba.pos[0] -= 5;
 	}
-	if (gl->keys[XK_Right]) {
+	if (keyState.isDown(XK_Right)) {
 		g.shiba.angle = 270;
 		img[5].animation = 1;
 		updateFrame(img[5], g.shiba.timer, 0.1);
 		g.shiba.pos[0] += 5;
 	}
-	if (gl->keys[XK_Up]) {
+	if (keyState.isDown(XK_Up)) {
 		g.shiba.angle = 360;
 		img[5].animation = 2;
 		updateFrame(img[5], g.shiba.timer, 0.1);
 		g.shiba.pos[1] += 5;
 	}
-	if (gl->keys[XK_Down]) {
+	if (keyState.isDown(XK_Down)) {
 		g.shiba.angle = 180;
 		img[5].animation = 0;
 		updateFrame(img[5], g.shiba.timer, 0.1);
 		g.shiba.pos[1] -= 5;
 	}
-	if (!gl->keys[XK_Left] && !gl->keys[XK_Right] && !gl->keys[XK_Up] && !gl->keys[XK_Down]) {
+	if (!keyState.isDown(XK_Left) && !keyState.isDown(XK_Right) && !keyState.isDown(XK_Up) && !keyState.isDown(XK_Down)) {
 		img[5].frame = 0;
 	}
-	if (gl->keys[XK_space]) {
+	if (keyState.isDown(XK_space)) {
 		shootBullet();
 	}
-	if (g.mouseThrustOn) {
-		//should thrust be turned off
-		struct timespec mtt;
-		clock_gettime(CLOCK_REALTIME, &mtt);
-		double tdif = timeDiff(&mtt, &g.mouseThrustTimer);
-		//std::cout << "tdif: " << tdif << std::endl;
-		if (tdif < -0.3)
-			g.mouseThrustOn = false;
-	}
 
 }
 
 // This creates the actual bullet, drawBullet() renders it, bulletPositionControl() makes it move. Could they be combined?
 void shootBullet()
 {
-	//a little time between each bullet
-	struct timespec bt;
-	clock_gettime(CLOCK_REALTIME, &bt);
-	double ts = timeDiff(&g.bulletTimer, &bt);
-	if (ts > 0.1) {
-		timeCopy(&g.bulletTimer, &bt);
-		if (g.nbullets < MAX_BULLETS) {
-			//shoot a bullet...
-			//Bullet *b = new Bullet;
-			Bullet *b = &g.barr[g.nbullets];
-			timeCopy(&b->time, &bt);
-			b->pos[0] = g.shiba.pos[0];
-			b->pos[1] = g.shiba.pos[1];
-			b->vel[0] = g.shiba.vel[0];
-			b->vel[1] = g.shiba.vel[1];
-			//convert shiba angle to radians
-			Flt rad = ((g.shiba.angle+90.0) / 360.0f) * PI * 2.0;
-			//convert angle to a vector
-			Flt xdir = cos(rad);
-			Flt ydir = sin(rad);
-			b->pos[0] += xdir*20.0f;
-			b->pos[1] += ydir*20.0f;
-			b->vel[0] += xdir*6.0f + rnd()*0.1;
-			b->vel[1] += ydir*6.0f + rnd()*0.1;
-			b->color[0] = 1.0f;
-			b->color[1] = 1.0f;
-			b->color[2] = 1.0f;
-			g.nbullets++;
+	//the pool keeps a little time between each bullet
+	//convert shiba angle to radians
+	Flt rad = ((g.shiba.angle+90.0) / 360.0f) * PI * 2.0;
+	//convert angle to a vector
+	Flt xdir = cos(rad);
+	Flt ydir = sin(rad);
+	bullets.fire(g.shiba.pos[0] + xdir*20.0f,
+		g.shiba.pos[1] + ydir*20.0f,
+		g.shiba.vel[0] + xdir*6.0f + rngStreams[RNG_BULLET].unit()*0.1,
+		g.shiba.vel[1] + ydir*6.0f + rngStreams[RNG_BULLET].unit()*0.1);
+}
+
+//soakTest(): plays games back to back for the given number of minutes
+//of play, drawing every frame, with a bot that spins and fires every
+//tick. A game ends when the bot runs out of lives or after
+//SOAK_GAME_TICKS, then the game over screen is shown for a moment and
+//the next one starts. Resources are sampled every SOAK_SAMPLE_TICKS.
+int soakTest(double minutes)
+{
+	SoakMonitor monitor;
+	long ticks = (long)(minutes * 60 * 60);
+	long gameTicks = 0;
+	int games = 1;
+	gl->gameMenu = 0;
+	gl->gameStart = 1;
+	gl->gameOver = 0;
+	gl->gameNew = false;
+	newGame();
+	for (long t = 0; t < ticks; t++) {
+		g.shiba.angle = (t * 7) % 360;
+		shootBullet();
+		physics();
+		gameTicks++;
+		//the game ends here and not in gameplayScreen, which would
+		//store the score and send it to the website
+		if (numLivesLeft.getLives() <= 0 || gameTicks >= SOAK_GAME_TICKS) {
+			endGame();
+			for (int f = 0; f < SOAK_GAMEOVER_FRAMES; f++) {
+				frameArena.reset();
+				render();
+				x11.swapBuffers();
+			}
+			gl->gameOver = 0;
+			gl->gameStart = 1;
+			gl->gameNew = false;
+			newGame();
+			gameTicks = 0;
+			games++;
 		}
+		frameArena.reset();
+		render();
+		x11.swapBuffers();
+		if (t % SOAK_SAMPLE_TICKS == 0)
+			monitor.sample();
+	}
+	printf("soak: %ld ticks, %d games\n", ticks, games);
+	int growing = monitor.report();
+	printf("soak: %s\n", growing ? "FAIL" : "ok");
+	return growing ? 1 : 0;
+}
+
+//callbacks the timing wheel can hold, snapshots save their place here
+static const WheelCallback wheelCallbacks[] = {
+	powerUpTimer,
+	flyingShibaLanded
+};
+
+//saveGame(): the whole run into out. The buffer is cleared and not
+//freed, so saving into the same one again does not allocate.
+bool saveGame(std::vector<unsigned char> &out)
+{
+	out.clear();
+	StateWriter w(out);
+	w.put(physicsTick);
+	w.put(g.shiba);
+	w.put(img[5].animation);
+	w.put(img[5].frame);
+	w.put(scoreObject.currentScore);
+	w.put(numLivesLeft.currentLives);
+	w.put(enemyController.enemyCap);
+	double ms = gl->ag->gameTimer.getElapsedMilliseconds();
+	w.put(ms);
+	rngSaveState(w);
+	waves.saveState(w);
+	bullets.saveState(w);
+	savePowerUps(w);
+	if (!gameEvents.saveState(w, wheelCallbacks, 2)) {
+		Log("snapshot: a timer has a callback that cannot be saved\n");
+		out.clear();
+		return false;
 	}
+	world.saveState(w);
+	return true;
+}
+
+//decodeGame(): loadGame without the safety net, a failure can leave
+//any part of the run half replaced
+static bool decodeGame(const unsigned char *data, int len)
+{
+	//components the snapshot names have to be registered first
+	enemyMask();
+	scatterShotMask();
+	bulletMask();
+	powerUpMask();
+	StateReader r(data, len);
+	double ms = 0.0;
+	r.get(physicsTick);
+	r.get(g.shiba);
+	r.get(img[5].animation);
+	r.get(img[5].frame);
+	r.get(scoreObject.currentScore);
+	r.get(numLivesLeft.currentLives);
+	r.get(enemyController.enemyCap);
+	r.get(ms);
+	bool ok = !r.bad && rngLoadState(r) && waves.loadState(r) &&
+		bullets.loadState(r) && loadPowerUps(r) &&
+		gameEvents.loadState(r, wheelCallbacks, 2) && world.loadState(r);
+	if (!ok)
+		return false;
+	gl->ag->gameTimer.setElapsedMilliseconds(ms);
+	return true;
+}
+
+//resetGame(): a fresh run with nothing carried over, for when a saved
+//one cannot be put back
+void resetGame()
+{
+	world.clear(0);
+	bullets.clear();
+	resetPowerUps();
+	newGame();
+	enemyController.enemyCap = EnemyControl().enemyCap;
+	rngSeed(rngCurrentSeed());
+	physicsTick = 0;
+	gl->ag->gameTimer.startTimer();
+}
+
+//loadGame(): all or nothing. The run it replaces is saved first and put
+//back when any part of the snapshot fails to load, or reset when it
+//could not be saved either.
+bool loadGame(const unsigned char *data, int len)
+{
+	if (len <= 0)
+		return false;
+	static std::vector<unsigned char> before;
+	bool saved = saveGame(before);
+	if (decodeGame(data, len))
+		return true;
+	Log("snapshot: could not load the saved game\n");
+	if (!saved || !decodeGame(&before[0], before.size()))
+		resetGame();
+	return false;
+}
+
+//suspendGame(): Escape during a game, the menu's Resume brings it back
+void suspendGame()
+{
+	if (saveGame(savedGame))
+		snapshotWriteFile(SNAPSHOT_FILE, savedGame);
 }
 
+void resumeGame()
+{
+	if (savedGame.empty())
+		return;
+	if (!loadGame(&savedGame[0], savedGame.size()))
+		resetGame();
+	savedGame.clear();
+}
+
+//checkpointGame(): every few seconds of play, so a crash or a power cut
+//loses no more than that
+void checkpointGame()
+{
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	if (!saveGame(savedGame))
+		return;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	snapshotWriteFile(SNAPSHOT_FILE, savedGame);
+	Log("checkpoint: %d bytes, saved in %.1f us\n", (int)savedGame.size(),
+		timeDiff(&t0, &t1) * 1e6);
+}
+
+//keys a replay keeps, a key's bit is its place in the table
+static const int replayHeldKeys[] = { XK_Left, XK_Right, XK_Up, XK_Down, XK_space };
+static const int replayTappedKeys[] = { XK_equal, XK_minus, XK_p, XK_s };
+#define NHELD (int)(sizeof replayHeldKeys / sizeof replayHeldKeys[0])
+#define NTAPPED (int)(sizeof replayTappedKeys / sizeof replayTappedKeys[0])
+
+//replayInput(): the keys physics() and check_keys() act on this tick
+ReplayInput replayInput()
+{
+	ReplayInput in = {0, 0};
+	for (int i = 0; i < NHELD; i++) {
+		if (keyState.isDown(replayHeldKeys[i]))
+			in.held |= 1 << i;
+	}
+	for (int i = 0; i < NTAPPED; i++) {
+		if (keyState.wasPressed(replayTappedKeys[i]))
+			in.tapped |= 1 << i;
+	}
+	return in;
+}
+
+//applyReplayInput(): the keys of a recorded tick, as consumeInput()
+//would have left them. Taps are skipped on a keyframe's own tick.
+void applyReplayInput(const ReplayInput &in, bool taps)
+{
+	keyState.reset();
+	for (int i = 0; i < NHELD; i++) {
+		if (in.held & (1 << i)) {
+			KeyEvent e;
+			e.key = replayHeldKeys[i];
+			e.press = true;
+			keyState.apply(e);
+		}
+	}
+	for (int i = 0; taps && i < NTAPPED; i++) {
+		if (in.tapped & (1 << i))
+			check_keys(replayTappedKeys[i]);
+	}
+}
+
+//startRecording(): a run is recorded from its first tick to endGame(),
+//one file however often it is suspended on the way
+void startRecording()
+{
+	if (recordPath && !recorder.recording())
+		recorder.open(recordPath, rngCurrentSeed(), physicsTick + 1);
+}
+
+//playFrom(): loads keyframe k straight from the map and plays on up to
+//tick. Returns true when tick is k's own, whose taps are already done.
+bool playFrom(const ReplayFile &rf, const ReplayKeyframe &k, unsigned int tick)
+{
+	if (!loadGame(rf.snapshot(k), k.snapshotLength))
+		return false;
+	for (unsigned int t = k.tick; t < tick && t < rf.endTick(); t++) {
+		applyReplayInput(rf.input(t), t != k.tick);
+		physics();
+	}
+	return tick == k.tick;
+}
+
+//seekReplay(): the state for playing tick next, from the keyframe at or
+//before it, so never more than REPLAY_KEYFRAME_TICKS ticks of work
+bool seekReplay(const ReplayFile &rf, unsigned int tick)
+{
+	return playFrom(rf, rf.keyframeFor(tick), tick);
+}
+
+//simulationHash(): everything that decides how the game plays on,
+//leaving out the clocks that only animate sprites
+unsigned int simulationHash()
+{
+	static std::vector<unsigned char> buf;
+	buf.clear();
+	StateWriter w(buf);
+	w.put(physicsTick);
+	w.put(g.shiba.pos);
+	w.put(g.shiba.vel);
+	w.put(g.shiba.angle);
+	w.put(scoreObject.currentScore);
+	w.put(numLivesLeft.currentLives);
+	rngSaveState(w);
+	bullets.saveState(w);
+	world.each(maskOf<Position>(), [&](Archetype &a) {
+		w.put(a.mask);
+		w.bytes(a.get<Position>(), a.size() * sizeof(Position));
+	});
+	return snapshotChecksum(&buf[0], buf.size());
+}
+
+//playReplay(): draws a recording from seconds in. Left and Right jump
+//ten seconds, space pauses, Escape quits.
+int playReplay(const char *path, double seconds)
+{
+	ReplayFile rf;
+	if (!rf.open(path)) {
+		printf("%s: not a replay this build can play\n", path);
+		return 1;
+	}
+	printf("replay: seed %llu, %u ticks, %d keyframes\n",
+		(unsigned long long)rf.seed(), rf.endTick() - rf.firstTick(),
+		rf.keyframes());
+	//a replay never stores a score
+	gl->spectating = true;
+	gl->gameMenu = 0;
+	gl->gameStart = 1;
+	gl->gameNew = false;
+	unsigned int tick = rf.firstTick() + (unsigned int)(seconds * 60);
+	bool seek = true, paused = false, tapsDone = false;
+	int done = 0;
+	while (!done) {
+		if (seek) {
+			if (tick >= rf.endTick())
+				tick = rf.endTick() - 1;
+			if (tick < rf.firstTick())
+				tick = rf.firstTick();
+			tapsDone = seekReplay(rf, tick);
+			seek = false;
+		}
+		frameScheduler.waitForEvents(inputThread.getWakeFd(), -1, physicsRate);
+		inputThread.clearWake();
+		KeyEvent e;
+		while (inputThread.queue.peek(e)) {
+			inputThread.queue.pop();
+			if (!e.press)
+				continue;
+			if (e.key == XK_Escape)
+				done = 1;
+			if (e.key == XK_space)
+				paused = !paused;
+			if (e.key == XK_Right || e.key == XK_Left) {
+				int step = (e.key == XK_Right ? 10 : -10) * 60;
+				tick = (int)tick + step < 0 ? 0 : tick + step;
+				seek = true;
+			}
+		}
+		while (x11.getXPending()) {
+			XEvent xe = x11.getXNextEvent();
+			x11.check_resize(&xe);
+		}
+		if (!paused && !seek && tick < rf.endTick()) {
+			applyReplayInput(rf.input(tick), !tapsDone);
+			tapsDone = false;
+			physics();
+			tick++;
+		}
+		int shown = (tick - rf.firstTick()) / 60;
+		updateTimer(shown / 60, shown % 60);
+		frameArena.reset();
+		render();
+		x11.swapBuffers();
+	}
+	return 0;
+}
+
+//checkReplay(): plays from every keyframe to the next one and checks
+//it lands on the state the next keyframe saved, then times a seek to
+//the last tick
+int checkReplay(const char *path)
+{
+	ReplayFile rf;
+	if (!rf.open(path)) {
+		printf("%s: not a replay this build can play\n", path);
+		return 1;
+	}
+	gl->spectating = true;
+	gl->gameMenu = 0;
+	gl->gameStart = 1;
+	gl->gameNew = false;
+	//a keyframe that does not load is a failure and there is nothing to
+	//play on from it
+	int bad = 0;
+	const ReplayKeyframe &first = rf.keyframe(0);
+	bool loaded = loadGame(rf.snapshot(first), first.snapshotLength);
+	if (!loaded) {
+		printf("keyframe 0 at tick %u does not load\n", first.tick);
+		bad++;
+	}
+	for (int k = 0; k + 1 < rf.keyframes(); k++) {
+		const ReplayKeyframe &next = rf.keyframe(k + 1);
+		bool played = loaded;
+		unsigned int hash = 0;
+		if (played) {
+			playFrom(rf, rf.keyframe(k), next.tick);
+			//the next keyframe was saved after its own tick's taps
+			applyReplayInput(rf.input(next.tick), true);
+			hash = simulationHash();
+		}
+		loaded = loadGame(rf.snapshot(next), next.snapshotLength);
+		if (!loaded) {
+			printf("keyframe %d at tick %u does not load\n", k + 1, next.tick);
+			bad++;
+		} else if (played && hash != simulationHash()) {
+			printf("keyframe %d at tick %u does not match\n", k + 1, next.tick);
+			bad++;
+		}
+	}
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	seekReplay(rf, rf.endTick() - 1);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	printf("replay: seed %llu, %u ticks, %d keyframes, %d failed, "
+		"seek to the end %.2f ms: %s\n", (unsigned long long)rf.seed(),
+		rf.endTick() - rf.firstTick(), rf.keyframes(), bad,
+		timeDiff(&t0, &t1) * 1000.0, bad ? "FAIL" : "ok");
+	return bad ? 1 : 0;
+}
+
+//spectateHeader(): everything about this tick that is not an entity
+SpectateHeader spectateHeader()
+{
+	SpectateHeader h;
+	h.tick = physicsTick;
+	h.playing = gl->gameStart;
+	h.x = g.shiba.pos[0];
+	h.y = g.shiba.pos[1];
+	h.animation = img[5].animation;
+	h.frame = img[5].frame;
+	h.score = (int)scoreObject.getScore();
+	h.lives = numLivesLeft.getLives();
+	h.seconds = (int)gl->ag->gameTimer.getElapsedSeconds();
+	return h;
+}
+
+//watchGame(): the viewer. Nothing is simulated here, the entities the
+//stream describes are put in the world and drawn by render() as if
+//this were the game. Escape quits.
+int watchGame(const char *host, int port)
+{
+	SpectateClient client;
+	if (!client.open(host, port))
+		return 1;
+	printf("watching %s port %d\n", host, port);
+	gl->spectating = true;
+	gl->gameMenu = 0;
+	gl->gameNew = false;
+	int done = 0;
+	while (!done) {
+		frameScheduler.waitForEvents(client.fd(), inputThread.getWakeFd(),
+			physicsRate);
+		inputThread.clearWake();
+		KeyEvent e;
+		while (inputThread.queue.peek(e)) {
+			if (e.press && e.key == XK_Escape)
+				done = 1;
+			inputThread.queue.pop();
+		}
+		while (x11.getXPending()) {
+			XEvent xe = x11.getXNextEvent();
+			x11.check_resize(&xe);
+		}
+		if (!client.poll())
+			continue;
+		client.mirror();
+		const SpectateHeader &h = client.view.head;
+		gl->gameStart = h.playing;
+		g.shiba.pos[0] = h.x;
+		g.shiba.pos[1] = h.y;
+		img[5].animation = h.animation;
+		img[5].frame = h.frame;
+		scoreObject.setScore(h.score);
+		numLivesLeft.setLives(h.lives);
+		updateTimer(h.seconds / 60, h.seconds % 60);
+		frameArena.reset();
+		render();
+		x11.swapBuffers();
+	}
+	client.report();
+	return 0;
+}
+
+//spectateTest(): streams a bot game to a viewer in this same process
+//over loopback. Every tick the viewer's copy is checked against the
+//world, and now and then a packet is thrown away to check the viewer
+//asks for a keyframe and catches up. Ends with the bandwidth report.
+int spectateTest(int ticks)
+{
+	if (!spectator.open(SPECTATE_PORT))
+		return 1;
+	SpectateClient client;
+	if (!client.open("127.0.0.1", SPECTATE_PORT))
+		return 1;
+	SpectateSnapshot expect;
+	int checked = 0, wrong = 0, behind = 0, lost = 0;
+	gl->gameMenu = 0;
+	gl->gameStart = 1;
+	gl->gameNew = false;
+	newGame();
+	//the hello has to arrive before the first packet goes out
+	usleep(10000);
+	for (int t = 0; t < ticks; t++) {
+		//nobody loses, the test is about the stream
+		numLivesLeft.setLives(3);
+		g.shiba.angle = (t * 7) % 360;
+		shootBullet();
+		physics();
+		SpectateHeader h = spectateHeader();
+		spectator.publish(h);
+		if (t % SPECTATE_TEST_LOSS == SPECTATE_TEST_LOSS - 1) {
+			char drop[1];
+			if (recv(client.fd(), drop, sizeof drop, 0) >= 0)
+				lost++;
+		}
+		client.poll();
+		if (client.view.head.tick != h.tick) {
+			behind++;
+			continue;
+		}
+		expect.capture(h);
+		checked++;
+		const std::vector<SpectateEntity> &a = expect.slots, &b = client.view.slots;
+		bool same = fabs(client.view.head.x - h.x) <= 0.5f / SPECTATE_QUANTA &&
+			fabs(client.view.head.y - h.y) <= 0.5f / SPECTATE_QUANTA &&
+			client.view.head.score == h.score;
+		for (unsigned int i = 0; same && i < a.size() && i < b.size(); i++) {
+			if (a[i].kind != b[i].kind || (a[i].kind != SPECTATE_EMPTY &&
+					(a[i].x != b[i].x || a[i].y != b[i].y ||
+					a[i].info != b[i].info || a[i].generation != b[i].generation)))
+				same = false;
+		}
+		if (expect.entities() != client.view.entities())
+			same = false;
+		if (!same)
+			wrong++;
+	}
+	spectator.report();
+	client.report();
+	spectator.close();
+	//a viewer that never got in sync has nothing wrong with it either
+	bool failed = wrong > 0 || checked == 0 ||
+		checked < ticks * SPECTATE_TEST_MIN_CHECKED;
+	printf("spectate: %d ticks, %d checked, %d wrong, %d behind after "
+		"%d lost packets: %s\n", ticks, checked, wrong, behind, lost,
+		failed ? "FAIL" : "ok");
+	return failed ? 1 : 0;
+}
+
+#ifdef DEBUG
+//allocCheck(): plays ticks of the game with a bot that spins and fires
+//every tick, drawing each one, then shows the game over and high score
+//screens for a while. All of it is played twice from the same seed. The
+//first pass grows every pool to its high water mark, so any allocation
+//in the second one is one the game makes every time and fails the check.
+int allocCheck(int ticks)
+{
+	int bad = 0;
+	for (int pass = 0; pass < 2; pass++) {
+		//same seed, tick and wheel, so both passes play the same ticks
+		resetGame();
+		gl->gameMenu = 0;
+		gl->gameStart = 1;
+		gl->gameNew = false;
+		gl->gameOver = 0;
+		gl->gameScores = 0;
+		for (int t = 0; t < ticks; t++) {
+			//nobody loses, the check is about the heap
+			numLivesLeft.setLives(3);
+			g.shiba.angle = (t * 7) % 360;
+			unsigned long before = allocTotal();
+			frameArena.reset();
+			{
+				ALLOC_PHASE(ALLOC_PHYSICS);
+				shootBullet();
+				physics();
+			}
+			{
+				ALLOC_PHASE(ALLOC_RENDER);
+				render();
+			}
+			unsigned long n = allocTotal() - before;
+			if (pass == 1 && n > 0) {
+				if (bad < 20)
+					printf("tick %d: %lu allocations, %d enemies\n",
+						t, n, enemyController.count());
+				bad++;
+			}
+		}
+		//each screen comes up the way it does after a game, with its
+		//scores read again
+		for (int screen = 0; screen < 2; screen++) {
+			gl->gameStart = 0;
+			gl->gameOver = (screen == 0);
+			gl->gameScores = (screen == 1);
+			gameOverInvalidate();
+			gl->ag->topScores = 1;
+			for (int f = 0; f < ALLOC_CHECK_FRAMES; f++) {
+				unsigned long before = allocTotal();
+				frameArena.reset();
+				{
+					ALLOC_PHASE(ALLOC_RENDER);
+					render();
+				}
+				unsigned long n = allocTotal() - before;
+				if (pass == 1 && n > 0) {
+					if (bad < 20)
+						printf("%s frame %d: %lu allocations\n",
+							screen == 0 ? "game over" : "high scores", f, n);
+					bad++;
+				}
+			}
+		}
+	}
+	gl->gameScores = 0;
+	allocReport();
+	printf("%d of %d replayed ticks and frames allocated: %s\n", bad,
+		ticks + 2 * ALLOC_CHECK_FRAMES, bad ? "FAIL" : "ok");
+	return bad ? 1 : 0;
+}
+#endif
+
 void render()
 {
 	//gameplayScreen();
 	glClear(GL_COLOR_BUFFER_BIT);
+	showScreenAssets(currentScreen());
 	
-	if (gl->gameMenu){
-		glClear(GL_COLOR_BUFFER_BIT);
+	//the other menu screens clear over the title menu, so skip it
+	if (gl->gameMenu && !gl->howTo && !gl->showCredits && !gl->gameScores){
 		menu(GL_TEXTURE_2D, gl->textures[7], gl->xres, gl->yres);
 	}
 	if (gl->gameStart){
@@ -893,26 +1639,45 @@ void render()
 	if (gl->gameOver){
 		gameOver(gl->xres, gl->yres, gl->user, gl->finalScore,GL_TEXTURE_2D, gl->textures[8]);
 	}
+	textFlush();
+}
+
+//currentScreen(): which screen the frame scheduler should pace for
+int currentScreen()
+{
+	if (gl->showCredits)
+		return FRAME_CREDITS;
+	if (gl->gameScores)
+		return FRAME_SCORES;
+	if (gl->howTo)
+		return FRAME_HOWTO;
+	if (gl->gameOver)
+		return FRAME_GAMEOVER;
+	if (gl->gameStart)
+		return FRAME_GAME;
+	return FRAME_MENU;
 }
 
 void gameplayScreen()
 {
+	static TextLabel bulletText(TEXT_FONT8B);
 	Rect r;
 	glClear(GL_COLOR_BUFFER_BIT);
 	glColor3f(1.0, 1.0, 1.0);
+	//the grass texture is cropped to the quarter drawn, see init_opengl()
 	glBindTexture(GL_TEXTURE_2D, gl->textures[6]);
 	glBegin(GL_QUADS);
 		glTexCoord2f(0.0, 1.0); glVertex2i(0, 0);
 		glTexCoord2f(0.0, 0.0); glVertex2i(0, gl->yres);
-		glTexCoord2f(0.25, 0.0); glVertex2i(gl->xres, gl->yres);
-		glTexCoord2f(0.25, 1.0); glVertex2i(gl->xres, 0);
+		glTexCoord2f(1.0, 0.0); glVertex2i(gl->xres, gl->yres);
+		glTexCoord2f(1.0, 1.0); glVertex2i(gl->xres, 0);
 	glEnd();
 	//
 	r.bot = gl->yres - 20;
 	r.left = 10;
 	r.center = 0;
 	//ggprint8b(&r, 16, 0x00ff0000, "3350 - Asteroids");
-	ggprint8b(&r, 16, 0x00ffff00, "n bullets: %i", g.nbullets);
+	bulletText.print(&r, 16, 0x00ffff00, "n bullets: %i", bullets.count());
 	//ggprint8b(&r, 16, 0x00ffff00, "n asteroids: %i", g.nasteroids);
 	//-------------------------------------------------------------------------
 	//Draw the shiba
@@ -924,44 +1689,46 @@ void gameplayScreen()
 	drawTimer(gl->xres);
 	scoreObject.textScoreDisplay();
 	numLivesLeft.livesTextDisplay();
-	if (numLivesLeft.getLives() == 0){
-		gl->gameStart ^= 1;
-		gl->gameOver ^= 1;
-		gl->gameNew = true;
+	if (numLivesLeft.getLives() == 0 && !gl->spectating){
 		printf("%s\n", "Sending score");
 		storeScore(gl->user, scoreObject.getScore());
-		gl->finalScore = scoreObject.getScore();
-		enemyController.cleanupEnemies();
-		power_ups.clear();
+		endGame();
 	}	 
 	//createEnemy(1);
+}
 
+//endGame(): out of lives, over to the game over screen
+void endGame()
+{
+	gl->gameStart = 0;
+	gl->gameOver = 1;
+	gl->gameNew = true;
+	gameOverInvalidate();
+	gl->finalScore = scoreObject.getScore();
+	enemyController.cleanupEnemies();
+	cleanUpShots();
+	bullets.clear();
+	resetPowerUps();
+	recorder.close();
+	//nothing left to resume
+	savedGame.clear();
+	unlink(SNAPSHOT_FILE);
+}
 
-	if (!flyingShiba) {
-		enemyController.updateAllPosition(g.shiba.pos[0], g.shiba.pos[1]);
-		enemyController.primeSpawner(int(gl->ag->gameTimer.getElapsedMilliseconds()), g.shiba.pos[0], g.shiba.pos[1]);
-	}
+//newGame(): lives, score and the shiba back to the start
+void newGame()
+{
+	enemyController.cleanupEnemies();
+	waves.restart();
+	numLivesLeft.currentLives = 3;
+	scoreObject.setScore(0);
+	g.shiba.pos[0] = (Flt)(gl->xres/2);
+	g.shiba.pos[1] = (Flt)(gl->yres/2);
 }
 
 void drawBullet()
 {
-	for (int i=0; i<g.nbullets; i++) {
-		Bullet *b = &g.barr[i];
-		//Log("draw bullet...\n");
-		glColor3f(1.0, 1.0, 1.0);
-		glBegin(GL_POINTS);
-		glVertex2f(b->pos[0],      b->pos[1]);
-		glVertex2f(b->pos[0]-1.0f, b->pos[1]);
-		glVertex2f(b->pos[0]+1.0f, b->pos[1]);
-		glVertex2f(b->pos[0],      b->pos[1]-1.0f);
-		glVertex2f(b->pos[0],      b->pos[1]+1.0f);
-		glColor3f(0.8, 0.8, 0.8);
-		glVertex2f(b->pos[0]-1.0f, b->pos[1]-1.0f);
-		glVertex2f(b->pos[0]-1.0f, b->pos[1]+1.0f);
-		glVertex2f(b->pos[0]+1.0f, b->pos[1]-1.0f);
-		glVertex2f(b->pos[0]+1.0f, b->pos[1]+1.0f);
-		glEnd();
-	}
+	bullets.draw();
 }
 
 void drawCredits()
@@ -971,12 +1738,14 @@ void drawCredits()
     	extern void danL(int, int, GLuint);
     	extern void mabelleC(int, int, GLuint);
 		extern void thomasB(int, int, GLuint);
+		static TextLabel title;
 		glClear(GL_COLOR_BUFFER_BIT);
+		textDiscard();
 		Rect rcred;
 		rcred.bot = gl->yres * 0.95f;
 		rcred.left = gl->xres/2;
 		rcred.center = 0;
-		ggprint16(&rcred, 16, 0x00ffff00, "Credits");
+		title.print(&rcred, 16, 0x00ffff00, "Credits");
 
 		// moves pictures so they scale to monitors resolution
 		float offset = 0.18f;
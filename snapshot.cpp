@@ -0,0 +1,83 @@
+//Program: snapshot.cpp
+//Game state snapshots for Shiba Survival
+//
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "snapshot.h"
+#include "log.h"
+
+#define SNAPSHOT_MAGIC 0x42494853
+
+struct SnapshotHeader {
+	unsigned int magic;
+	unsigned int version;
+	unsigned int length;
+	unsigned int checksum;
+};
+
+//snapshotChecksum(): 32 bit FNV-1a
+unsigned int snapshotChecksum(const unsigned char *data, int len)
+{
+	unsigned int h = 2166136261u;
+	for (int i = 0; i < len; i++) {
+		h ^= data[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+bool snapshotWriteFile(const char *path, const std::vector<unsigned char> &data)
+{
+	char tmp[256];
+	snprintf(tmp, sizeof tmp, "%s.tmp", path);
+	SnapshotHeader h;
+	h.magic = SNAPSHOT_MAGIC;
+	h.version = SNAPSHOT_VERSION;
+	h.length = data.size();
+	h.checksum = snapshotChecksum(data.empty() ? NULL : &data[0], data.size());
+	int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		Log("snapshot: cannot write %s\n", tmp);
+		return false;
+	}
+	bool ok = write(fd, &h, sizeof h) == (ssize_t)sizeof h &&
+		(data.empty() ||
+		write(fd, &data[0], data.size()) == (ssize_t)data.size());
+	close(fd);
+	if (!ok || rename(tmp, path) != 0) {
+		Log("snapshot: writing %s failed\n", path);
+		unlink(tmp);
+		return false;
+	}
+	return true;
+}
+
+bool snapshotReadFile(const char *path, std::vector<unsigned char> &data)
+{
+	FILE *fp = fopen(path, "rb");
+	if (!fp)
+		return false;
+	SnapshotHeader h;
+	struct stat st;
+	bool ok = fstat(fileno(fp), &st) == 0 &&
+		fread(&h, sizeof h, 1, fp) == 1 && h.magic == SNAPSHOT_MAGIC &&
+		h.version == SNAPSHOT_VERSION &&
+		//a bad length must not get as far as the resize
+		(off_t)h.length == st.st_size - (off_t)sizeof h;
+	if (ok) {
+		data.resize(h.length);
+		ok = h.length == 0 || fread(&data[0], h.length, 1, fp) == 1;
+	}
+	fclose(fp);
+	if (ok && snapshotChecksum(data.empty() ? NULL : &data[0],
+			data.size()) != h.checksum)
+		ok = false;
+	if (!ok) {
+		Log("snapshot: %s is not a usable snapshot\n", path);
+		data.clear();
+	}
+	return ok;
+}
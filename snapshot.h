@@ -0,0 +1,100 @@
+//Program: snapshot.h
+//Game state snapshots for Shiba Survival
+//
+//Every part of the simulation can write itself into a StateWriter and
+//read itself back from a StateReader. Components, random streams and
+//the timing wheel are plain data, so most of a snapshot is a handful
+//of memcpy calls and a busy game saves in a few microseconds. That is
+//cheap enough to suspend a run on Escape, to checkpoint it every few
+//seconds and to drop keyframes into a replay.
+//
+//A snapshot file is a small header (magic, version, length and an
+//FNV-1a checksum) and the bytes. Files are written to a temporary name
+//and renamed over the old one, so a crash mid write leaves the previous
+//checkpoint in place. Snapshots are only read back by the same build:
+//any change to what gets saved must bump SNAPSHOT_VERSION.
+//
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <vector>
+#include <cstring>
+#include <type_traits>
+
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_FILE "checkpoint.sav"
+//physics ticks between checkpoints, five seconds
+#define SNAPSHOT_CHECKPOINT_TICKS (5 * 60)
+
+class StateWriter {
+	private:
+		std::vector<unsigned char> &out;
+	public:
+		StateWriter(std::vector<unsigned char> &buf) : out(buf) {}
+		void bytes(const void *p, int n) {
+			const unsigned char *b = (const unsigned char *)p;
+			out.insert(out.end(), b, b + n);
+		}
+		template <class T>
+		void put(const T &v) {
+			static_assert(std::is_trivially_copyable<T>::value,
+				"snapshots copy values as bytes");
+			bytes(&v, sizeof v);
+		}
+		//a count followed by the elements
+		template <class T>
+		void putVector(const std::vector<T> &v) {
+			put((int)v.size());
+			if (!v.empty())
+				bytes(&v[0], v.size() * sizeof(T));
+		}
+		int size() const { return out.size(); }
+};
+
+//reading past the end or a bad count sets bad and leaves zeros
+class StateReader {
+	private:
+		const unsigned char *p, *end;
+	public:
+		bool bad;
+		StateReader(const unsigned char *data, int len) {
+			p = data;
+			end = data + len;
+			bad = false;
+		}
+		void bytes(void *dst, int n) {
+			if (n < 0 || end - p < n) {
+				bad = true;
+				memset(dst, 0, n > 0 ? n : 0);
+				return;
+			}
+			memcpy(dst, p, n);
+			p += n;
+		}
+		template <class T>
+		void get(T &v) {
+			static_assert(std::is_trivially_copyable<T>::value,
+				"snapshots copy values as bytes");
+			bytes(&v, sizeof v);
+		}
+		template <class T>
+		void getVector(std::vector<T> &v) {
+			int n = 0;
+			get(n);
+			if (n < 0 || (long)n * (long)sizeof(T) > end - p) {
+				bad = true;
+				n = 0;
+			}
+			v.resize(n);
+			if (n > 0)
+				bytes(&v[0], n * sizeof(T));
+		}
+		int left() const { return end - p; }
+};
+
+unsigned int snapshotChecksum(const unsigned char *data, int len);
+bool snapshotWriteFile(const char *path, const std::vector<unsigned char> &data);
+//false if the file is missing, short, from another version or corrupt
+bool snapshotReadFile(const char *path, std::vector<unsigned char> &data);
+
+#endif
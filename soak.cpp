@@ -0,0 +1,123 @@
+//Program: soak.cpp
+//Resource growth sampling for Shiba Survival
+//
+#include <stdio.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <GL/glx.h>
+#include "soak.h"
+#include "ecs.h"
+#include "timingwheel.h"
+#include "arena.h"
+#include "amberZ.h"
+#include "log.h"
+
+extern AmbersGlobals *ag;
+
+static const char *metricNames[SOAK_NMETRICS] = {
+	"rss kB", "open fds", "textures", "entities", "entity slots",
+	"timers", "arena kB", "score rows"
+};
+
+//soakRssKb(): resident set from /proc/self/statm, in pages
+long soakRssKb()
+{
+	long size = 0, resident = 0;
+	FILE *fp = fopen("/proc/self/statm", "r");
+	if (!fp)
+		return -1;
+	if (fscanf(fp, "%ld %ld", &size, &resident) != 2)
+		resident = -1;
+	fclose(fp);
+	return resident < 0 ? -1 : resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+int soakOpenFds()
+{
+	DIR *dir = opendir("/proc/self/fd");
+	if (!dir)
+		return -1;
+	int n = 0;
+	struct dirent *d;
+	while ((d = readdir(dir)) != NULL) {
+		if (d->d_name[0] != '.')
+			n++;
+	}
+	closedir(dir);
+	//the one opendir is holding
+	return n - 1;
+}
+
+//GL has no call that lists textures, but names are handed out counting
+//up from 1, so checking the low ones finds them all
+int soakTextureCount()
+{
+	int n = 0;
+	for (GLuint i = 1; i <= SOAK_TEXTURE_PROBE; i++) {
+		if (glIsTexture(i))
+			n++;
+	}
+	return n;
+}
+
+void SoakMonitor::sample()
+{
+	long v[SOAK_NMETRICS];
+	v[SOAK_RSS_KB] = soakRssKb();
+	v[SOAK_FDS] = soakOpenFds();
+	v[SOAK_TEXTURES] = soakTextureCount();
+	v[SOAK_ENTITIES] = world.count(0);
+	v[SOAK_ENTITY_SLOTS] = world.slots();
+	v[SOAK_TIMERS] = gameEvents.pending();
+	v[SOAK_ARENA_KB] = frameArena.size() / 1024;
+	v[SOAK_SCORE_ROWS] = ag->scores.size();
+	for (int i = 0; i < SOAK_NMETRICS; i++)
+		samples[i].push_back(v[i]);
+	Log("soak sample %d: rss %ld kB, %ld fds, %ld textures, %ld entities\n",
+		count(), v[SOAK_RSS_KB], v[SOAK_FDS], v[SOAK_TEXTURES],
+		v[SOAK_ENTITIES]);
+}
+
+bool SoakMonitor::growing(int metric) const
+{
+	const std::vector<long> &s = samples[metric];
+	int n = s.size();
+	if (n < 8)
+		return false;
+	long low[3];
+	int start = n / 4;
+	for (int q = 0; q < 3; q++) {
+		int begin = start + (n - start) * q / 3;
+		int end = start + (n - start) * (q + 1) / 3;
+		low[q] = s[begin];
+		for (int i = begin; i < end; i++) {
+			if (s[i] < low[q])
+				low[q] = s[i];
+		}
+	}
+	return low[1] > low[0] && low[2] > low[1];
+}
+
+int SoakMonitor::report() const
+{
+	int bad = 0;
+	printf("%d samples, %d ticks apart\n", count(), SOAK_SAMPLE_TICKS);
+	printf("%-14s %10s %10s %10s   %s\n", "metric", "first", "last", "peak", "trend");
+	for (int i = 0; i < SOAK_NMETRICS; i++) {
+		const std::vector<long> &s = samples[i];
+		if (s.empty())
+			continue;
+		long peak = s[0];
+		for (unsigned int j = 0; j < s.size(); j++) {
+			if (s[j] > peak)
+				peak = s[j];
+		}
+		bool grows = growing(i);
+		bad += grows;
+		printf("%-14s %10ld %10ld %10ld   %s\n", metricNames[i], s[0],
+			s.back(), peak, grows ? "GROWING" : "flat");
+	}
+	if (count() < 8)
+		printf("too few samples to call a trend\n");
+	return bad;
+}
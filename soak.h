@@ -0,0 +1,54 @@
+//Program: soak.h
+//Resource growth sampling for Shiba Survival
+//
+//The soak test plays game after game for as long as it is told to, and
+//every so often writes down how much memory, how many textures, open
+//files and entities the process is holding. Leaks show up from the
+//outside as a number that never gets back down to where it was. After
+//skipping the first quarter of the run as warm up, a number whose
+//lowest value rises in each of the three quarters left is reported as
+//growing. Lows and not highs, because every new game starts empty and
+//a busy moment in a later game is not a leak.
+//
+#ifndef SOAK_H
+#define SOAK_H
+
+#include <vector>
+
+//physics ticks between samples, ten seconds of play
+#define SOAK_SAMPLE_TICKS 600
+//longest game before the bot gives up and starts another, five minutes
+#define SOAK_GAME_TICKS (5 * 60 * 60)
+//frames the game over screen stays up between games
+#define SOAK_GAMEOVER_FRAMES 120
+//texture names checked with glIsTexture, from 1 up
+#define SOAK_TEXTURE_PROBE 4096
+
+enum {
+	SOAK_RSS_KB,
+	SOAK_FDS,
+	SOAK_TEXTURES,
+	SOAK_ENTITIES,
+	SOAK_ENTITY_SLOTS,
+	SOAK_TIMERS,
+	SOAK_ARENA_KB,
+	SOAK_SCORE_ROWS,
+	SOAK_NMETRICS
+};
+
+class SoakMonitor {
+	private:
+		std::vector<long> samples[SOAK_NMETRICS];
+		bool growing(int metric) const;
+	public:
+		void sample();
+		int count() const { return samples[0].size(); }
+		//prints every metric, returns how many look like they grow
+		int report() const;
+};
+
+long soakRssKb();
+int soakOpenFds();
+int soakTextureCount();
+
+#endif
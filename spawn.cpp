@@ -0,0 +1,79 @@
+//Program: spawn.cpp
+//Spawn position sampler for Shiba Survival
+//
+#include "spawn.h"
+#include "arena.h"
+
+SpawnRegion::SpawnRegion()
+{
+	nrects = 0;
+	total = 0.0f;
+	fallback[0] = fallback[1] = 0.0f;
+}
+
+void SpawnRegion::add(float x0, float y0, float x1, float y1)
+{
+	if (x1 <= x0 || y1 <= y0)
+		return;
+	SpawnRect r = { x0, y0, x1, y1 };
+	rects[nrects] = r;
+	total += (x1 - x0) * (y1 - y0);
+	upTo[nrects] = total;
+	nrects++;
+}
+
+void SpawnRegion::build(float xres, float yres, float cx, float cy, float away)
+{
+	nrects = 0;
+	total = 0.0f;
+	float left = cx - away;
+	float right = cx + away;
+	float bot = cy - away;
+	float top = cy + away;
+	if (left < 0)
+		left = 0;
+	if (right > xres)
+		right = xres;
+	if (bot < 0)
+		bot = 0;
+	if (top > yres)
+		top = yres;
+	//full width strips below and above the square
+	add(0, 0, xres, bot);
+	add(0, top, xres, yres);
+	//and the pieces beside it
+	add(0, bot, left, top);
+	add(right, bot, xres, top);
+	//the square can only cover the whole screen on a tiny window, then
+	//use the corner furthest from the shiba
+	fallback[0] = cx < xres / 2 ? xres : 0;
+	fallback[1] = cy < yres / 2 ? yres : 0;
+}
+
+//u picks the rectangle by area, ux and uy the point inside it
+void SpawnRegion::pick(float u, float ux, float uy, float *out)
+{
+	if (nrects == 0) {
+		out[0] = fallback[0];
+		out[1] = fallback[1];
+		return;
+	}
+	float target = u * total;
+	int i = 0;
+	while (i < nrects - 1 && target >= upTo[i])
+		i++;
+	const SpawnRect &r = rects[i];
+	out[0] = r.x0 + ux * (r.x1 - r.x0);
+	out[1] = r.y0 + uy * (r.y1 - r.y0);
+}
+
+void SpawnRegion::sampleMany(Rng &rng, int n, float *xy)
+{
+	if (n <= 0)
+		return;
+	ArenaScope scope;
+	ArenaVector<float> u(n * 3);
+	rng.fillUnit(&u[0], n * 3);
+	for (int i = 0; i < n; i++)
+		pick(u[i * 3], u[i * 3 + 1], u[i * 3 + 2], &xy[i * 2]);
+}
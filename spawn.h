@@ -0,0 +1,37 @@
+//Program: spawn.h
+//Spawn position sampler for Shiba Survival
+//
+//The place enemies may appear is the screen minus a square kept clear
+//around the shiba. That shape is always at most four rectangles (the
+//strips below and above the square and the pieces left and right of
+//it), so the sampler stores those with their areas, picks one weighted
+//by area and then a uniform point inside it. Every sample costs the
+//same no matter where the shiba is, and there is no retrying.
+//
+#ifndef SPAWN_H
+#define SPAWN_H
+
+#include "rng.h"
+
+struct SpawnRect {
+	float x0, y0, x1, y1;
+};
+
+class SpawnRegion {
+	private:
+		SpawnRect rects[4];
+		float upTo[4];
+		int nrects;
+		float total;
+		float fallback[2];
+		void add(float x0, float y0, float x1, float y1);
+		void pick(float u, float ux, float uy, float *out);
+	public:
+		SpawnRegion();
+		//screen is xres by yres, keep away from (cx, cy) by away
+		void build(float xres, float yres, float cx, float cy, float away);
+		//xy gets n pairs of x, y
+		void sampleMany(Rng &rng, int n, float *xy);
+};
+
+#endif
@@ -0,0 +1,733 @@
+//Program: spectate.cpp
+//Live spectator stream for Shiba Survival
+//
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "spectate.h"
+#include "josephS.h"
+#include "danL.h"
+#include "bullets.h"
+#include "log.h"
+
+SpectateServer spectator;
+
+#define SPECTATE_MAGIC 0x5053
+#define SPECTATE_FLAG_KEYFRAME 1
+#define SPECTATE_FLAG_PLAYING 2
+//entity ids have 20 bits of index
+#define SPECTATE_MAX_SLOTS (1 << 20)
+
+//what a record does to its slot, kept in the low bits of the index step
+enum {
+	SPECTATE_ADD,
+	SPECTATE_MOVE,
+	SPECTATE_REMOVE
+};
+
+//what one entity would cost sent plainly: id, kind, two floats and
+//the two info bytes
+#define SPECTATE_RAW_ENTITY 15
+
+static const SpectateEntity emptySlot = { SPECTATE_EMPTY, 0, 0, 0, 0, 0 };
+
+static const char *kindNames[SPECTATE_NKINDS] = {
+	"enemies", "scatter shots", "bullets", "power-ups"
+};
+
+static double monotonicSeconds()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static short quantize(float v)
+{
+	float q = v * SPECTATE_QUANTA;
+	if (q > 32767.0f)
+		return 32767;
+	if (q < -32768.0f)
+		return -32768;
+	return (short)(q < 0.0f ? q - 0.5f : q + 0.5f);
+}
+
+//=============================================================
+// Packet bytes
+//=============================================================
+
+static void putByte(std::vector<unsigned char> &out, int b)
+{
+	out.push_back((unsigned char)b);
+}
+
+static void putShort(std::vector<unsigned char> &out, int v)
+{
+	out.push_back(v & 0xff);
+	out.push_back((v >> 8) & 0xff);
+}
+
+static void putVarint(std::vector<unsigned char> &out, unsigned int v)
+{
+	while (v >= 0x80) {
+		out.push_back((v & 0x7f) | 0x80);
+		v >>= 7;
+	}
+	out.push_back(v);
+}
+
+//small negative numbers stay small
+static void putSigned(std::vector<unsigned char> &out, int v)
+{
+	putVarint(out, ((unsigned int)v << 1) ^ (unsigned int)(v >> 31));
+}
+
+//reads from a packet, going past the end sets bad instead of reading on
+struct PacketReader {
+	const unsigned char *p, *end;
+	bool bad;
+	int byte() {
+		if (p >= end) {
+			bad = true;
+			return 0;
+		}
+		return *p++;
+	}
+	int shortValue() {
+		int lo = byte();
+		return (short)(lo | (byte() << 8));
+	}
+	unsigned int varint() {
+		unsigned int v = 0;
+		for (int shift = 0; shift < 35; shift += 7) {
+			int b = byte();
+			v |= (unsigned int)(b & 0x7f) << shift;
+			if (!(b & 0x80))
+				return v;
+		}
+		bad = true;
+		return 0;
+	}
+	int signedValue() {
+		unsigned int v = varint();
+		return (int)(v >> 1) ^ -(int)(v & 1);
+	}
+};
+
+//=============================================================
+// Snapshots
+//=============================================================
+
+SpectateSnapshot::SpectateSnapshot()
+{
+	clear();
+}
+
+void SpectateSnapshot::clear()
+{
+	memset(&head, 0, sizeof head);
+	slots.assign(slots.size(), emptySlot);
+	memset(count, 0, sizeof count);
+}
+
+int SpectateSnapshot::entities() const
+{
+	int n = 0;
+	for (int k = 0; k < SPECTATE_NKINDS; k++)
+		n += count[k];
+	return n;
+}
+
+//store(): one entity into its slot
+static void store(SpectateSnapshot &s, Entity e, int kind, float x, float y,
+		int info, int half)
+{
+	unsigned int index = e & 0xfffff;
+	if (index >= s.slots.size())
+		s.slots.resize(index + 1, emptySlot);
+	SpectateEntity &se = s.slots[index];
+	se.kind = kind;
+	se.info = info;
+	se.half = half;
+	se.generation = e >> 20;
+	se.x = quantize(x);
+	se.y = quantize(y);
+	s.count[kind]++;
+}
+
+void SpectateSnapshot::capture(const SpectateHeader &h)
+{
+	clear();
+	head = h;
+	if (slots.size() < (unsigned int)world.slots())
+		slots.resize(world.slots(), emptySlot);
+	world.each(maskOf<Position, Size, EnemyInfo>(), [&](Archetype &a) {
+		Position *p = a.get<Position>();
+		Size *sz = a.get<Size>();
+		EnemyInfo *info = a.get<EnemyInfo>();
+		for (int i = 0; i < a.size(); i++)
+			store(*this, a.ids[i], SPECTATE_ENEMY, p[i].x, p[i].y,
+				info[i].imageIndex, (int)sz[i].half);
+	});
+	world.each(maskOf<Position, Size, ScatterShotTag>(), [&](Archetype &a) {
+		Position *p = a.get<Position>();
+		Size *sz = a.get<Size>();
+		for (int i = 0; i < a.size(); i++)
+			store(*this, a.ids[i], SPECTATE_SCATTER, p[i].x, p[i].y,
+				0, (int)sz[i].half);
+	});
+	world.each(bulletMask(), [&](Archetype &a) {
+		Position *p = a.get<Position>();
+		for (int i = 0; i < a.size(); i++)
+			store(*this, a.ids[i], SPECTATE_BULLET, p[i].x, p[i].y, 0, 0);
+	});
+	world.each(powerUpMask(), [&](Archetype &a) {
+		Position *p = a.get<Position>();
+		PowerUpInfo *info = a.get<PowerUpInfo>();
+		for (int i = 0; i < a.size(); i++)
+			store(*this, a.ids[i], SPECTATE_POWERUP, p[i].x, p[i].y,
+				info[i].type, 0);
+	});
+}
+
+//=============================================================
+// Encoding
+//=============================================================
+
+//Packet: magic, flags, tick and the tick it builds on, the header
+//values, a record count, then records in slot order. Every record
+//starts with (slot step << 2 | what it does).
+int spectateEncode(const SpectateSnapshot &cur, const SpectateSnapshot *base,
+		std::vector<unsigned char> &out)
+{
+	const SpectateHeader &h = cur.head;
+	out.clear();
+	putShort(out, SPECTATE_MAGIC);
+	putByte(out, (base ? 0 : SPECTATE_FLAG_KEYFRAME) |
+		(h.playing ? SPECTATE_FLAG_PLAYING : 0));
+	putVarint(out, h.tick);
+	putVarint(out, base ? base->head.tick : 0);
+	putShort(out, quantize(h.x));
+	putShort(out, quantize(h.y));
+	putByte(out, h.animation);
+	putByte(out, h.frame);
+	putSigned(out, h.score);
+	putSigned(out, h.lives);
+	putVarint(out, h.seconds);
+	//patched in once the records are written
+	int countAt = out.size();
+	putByte(out, 0);
+	putByte(out, 0);
+	putByte(out, 0);
+	int records = 0;
+	unsigned int last = 0;
+	unsigned int n = cur.slots.size();
+	if (base && base->slots.size() > n)
+		n = base->slots.size();
+	for (unsigned int i = 0; i < n; i++) {
+		const SpectateEntity &c = i < cur.slots.size() ? cur.slots[i] : emptySlot;
+		const SpectateEntity &b = (base && i < base->slots.size()) ?
+			base->slots[i] : emptySlot;
+		if (c.kind == SPECTATE_EMPTY && b.kind == SPECTATE_EMPTY)
+			continue;
+		bool same = c.kind == b.kind && c.generation == b.generation &&
+			c.info == b.info && c.half == b.half;
+		if (same && c.x == b.x && c.y == b.y)
+			continue;
+		if (c.kind == SPECTATE_EMPTY) {
+			putVarint(out, (i - last) << 2 | SPECTATE_REMOVE);
+		} else if (same) {
+			putVarint(out, (i - last) << 2 | SPECTATE_MOVE);
+			putSigned(out, c.x - b.x);
+			putSigned(out, c.y - b.y);
+		} else {
+			putVarint(out, (i - last) << 2 | SPECTATE_ADD);
+			putByte(out, c.kind);
+			putByte(out, c.info);
+			putByte(out, c.half);
+			putVarint(out, c.generation);
+			putShort(out, c.x);
+			putShort(out, c.y);
+		}
+		last = i;
+		records++;
+	}
+	//a three byte varint, always, so the count can be written last
+	out[countAt] = (records & 0x7f) | 0x80;
+	out[countAt + 1] = ((records >> 7) & 0x7f) | 0x80;
+	out[countAt + 2] = (records >> 14) & 0x7f;
+	return records;
+}
+
+int spectateDecode(const unsigned char *buf, int len, SpectateSnapshot &view)
+{
+	PacketReader r = { buf, buf + len, false };
+	if ((r.shortValue() & 0xffff) != SPECTATE_MAGIC)
+		return -1;
+	int flags = r.byte();
+	unsigned int tick = r.varint();
+	unsigned int baseTick = r.varint();
+	if (r.bad)
+		return -1;
+	bool keyframe = flags & SPECTATE_FLAG_KEYFRAME;
+	//a fresh or cleared view has tick 0, which no delta builds on
+	if (!keyframe && view.head.tick != baseTick)
+		return 0;
+	SpectateHeader h;
+	h.tick = tick;
+	h.playing = flags & SPECTATE_FLAG_PLAYING;
+	h.x = (float)r.shortValue() / SPECTATE_QUANTA;
+	h.y = (float)r.shortValue() / SPECTATE_QUANTA;
+	h.animation = r.byte();
+	h.frame = r.byte();
+	h.score = r.signedValue();
+	h.lives = r.signedValue();
+	h.seconds = r.varint();
+	int records = r.varint();
+	if (r.bad)
+		return -1;
+	if (keyframe)
+		view.clear();
+	unsigned int slot = 0;
+	for (int k = 0; k < records && !r.bad; k++) {
+		unsigned int v = r.varint();
+		slot += v >> 2;
+		if (slot >= SPECTATE_MAX_SLOTS)
+			return -1;
+		if (slot >= view.slots.size())
+			view.slots.resize(slot + 1, emptySlot);
+		SpectateEntity &e = view.slots[slot];
+		switch (v & 3) {
+			case SPECTATE_ADD: {
+				//kind and info index arrays on the viewer, so nothing
+				//is changed until both are known to fit
+				unsigned int kind = r.byte();
+				unsigned int info = r.byte();
+				if (kind >= SPECTATE_NKINDS)
+					return -1;
+				if (kind == SPECTATE_ENEMY && info >= numEnemyImages)
+					return -1;
+				if (kind == SPECTATE_POWERUP && info >= SPECTATE_POWERUP_TYPES)
+					return -1;
+				if (e.kind != SPECTATE_EMPTY)
+					view.count[e.kind]--;
+				e.kind = kind;
+				e.info = info;
+				e.half = r.byte();
+				e.generation = r.varint();
+				e.x = r.shortValue();
+				e.y = r.shortValue();
+				view.count[e.kind]++;
+				break;
+			}
+			case SPECTATE_MOVE:
+				if (e.kind == SPECTATE_EMPTY)
+					return -1;
+				e.x += r.signedValue();
+				e.y += r.signedValue();
+				break;
+			case SPECTATE_REMOVE:
+				if (e.kind != SPECTATE_EMPTY)
+					view.count[e.kind]--;
+				e.kind = SPECTATE_EMPTY;
+				break;
+			default:
+				return -1;
+		}
+	}
+	if (r.bad)
+		return -1;
+	view.head = h;
+	return 1;
+}
+
+//=============================================================
+// Server, in the game
+//=============================================================
+
+SpectateServer::SpectateServer()
+{
+	sock = -1;
+	current = 0;
+	keyframeDue = true;
+	lastKeyframe = 0;
+	secret = 0;
+	memset(&stats, 0, sizeof stats);
+}
+
+SpectateServer::~SpectateServer()
+{
+	close();
+}
+
+bool SpectateServer::open(int port, const char *local)
+{
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof addr);
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if (!local)
+		local = SPECTATE_ADDR;
+	if (inet_pton(AF_INET, local, &addr.sin_addr) != 1) {
+		Log("spectate: %s is not an IPv4 address\n", local);
+		return false;
+	}
+	sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+	if (sock < 0) {
+		Log("spectate: socket: %s\n", strerror(errno));
+		return false;
+	}
+	if (bind(sock, (struct sockaddr *)&addr, sizeof addr) < 0) {
+		Log("spectate: %s port %d: %s\n", local, port, strerror(errno));
+		close();
+		return false;
+	}
+	//the nonces are only as good as this is hard to guess
+	int fd = ::open("/dev/urandom", O_RDONLY);
+	if (fd < 0 || read(fd, &secret, sizeof secret) != (ssize_t)sizeof secret)
+		secret = ((unsigned long long)time(NULL) << 32) ^ getpid() ^
+			(unsigned long long)(monotonicSeconds() * 1e9);
+	if (fd >= 0)
+		::close(fd);
+	Log("spectate: waiting for viewers on %s port %d\n", local, port);
+	return true;
+}
+
+//nonceFor(): what a viewer at from has to send back, the same every
+//time so nothing is kept for addresses that never answer
+unsigned int SpectateServer::nonceFor(const struct sockaddr_in &from) const
+{
+	unsigned long long z = secret ^
+		((unsigned long long)from.sin_addr.s_addr << 16) ^ from.sin_port;
+	z += 0x9e3779b97f4a7c15ull;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	z ^= z >> 31;
+	//0 is what a viewer sends before it has a nonce
+	return (unsigned int)z | 1;
+}
+
+void SpectateServer::close()
+{
+	if (sock >= 0)
+		::close(sock);
+	sock = -1;
+	viewers.clear();
+}
+
+//listen(): messages from viewers. Anything without the sender's nonce
+//is answered with it and otherwise ignored. With it, 'H' joins or keeps
+//a viewer on the list and 'K' asks for a keyframe after a lost packet.
+void SpectateServer::listen()
+{
+	double now = monotonicSeconds();
+	SpectateHello msg;
+	struct sockaddr_in from;
+	socklen_t fromLen = sizeof from;
+	int n;
+	while ((n = recvfrom(sock, &msg, sizeof msg, 0, (struct sockaddr *)&from,
+			&fromLen)) > 0) {
+		fromLen = sizeof from;
+		//too short to answer without sending more than came in
+		if (n < (int)sizeof msg)
+			continue;
+		unsigned int nonce = nonceFor(from);
+		if (msg.nonce != nonce) {
+			SpectateHello challenge;
+			memset(&challenge, 0, sizeof challenge);
+			challenge.what = 'N';
+			challenge.nonce = nonce;
+			sendto(sock, &challenge, sizeof challenge, 0,
+				(struct sockaddr *)&from, sizeof from);
+			continue;
+		}
+		unsigned int i;
+		for (i = 0; i < viewers.size(); i++) {
+			if (viewers[i].addr.sin_addr.s_addr == from.sin_addr.s_addr &&
+					viewers[i].addr.sin_port == from.sin_port)
+				break;
+		}
+		if (i == viewers.size()) {
+			if (viewers.size() >= SPECTATE_MAX_VIEWERS) {
+				if (stats.refused++ == 0)
+					Log("spectate: %d viewers already, turning %s:%d away\n",
+						SPECTATE_MAX_VIEWERS, inet_ntoa(from.sin_addr),
+						ntohs(from.sin_port));
+				continue;
+			}
+			SpectateViewer v;
+			v.addr = from;
+			viewers.push_back(v);
+			keyframeDue = true;
+			Log("spectate: viewer %s:%d joined\n", inet_ntoa(from.sin_addr),
+				ntohs(from.sin_port));
+		}
+		viewers[i].lastHeard = now;
+		if (msg.what == 'K')
+			keyframeDue = true;
+	}
+	for (unsigned int i = 0; i < viewers.size(); ) {
+		if (now - viewers[i].lastHeard > SPECTATE_VIEWER_TIMEOUT) {
+			Log("spectate: viewer %s:%d left\n",
+				inet_ntoa(viewers[i].addr.sin_addr),
+				ntohs(viewers[i].addr.sin_port));
+			viewers.erase(viewers.begin() + i);
+		} else {
+			i++;
+		}
+	}
+}
+
+void SpectateServer::publish(const SpectateHeader &h)
+{
+	if (sock < 0)
+		return;
+	listen();
+	if (viewers.empty()) {
+		keyframeDue = true;
+		return;
+	}
+	if (h.tick - lastKeyframe >= SPECTATE_KEYFRAME)
+		keyframeDue = true;
+	SpectateSnapshot &cur = snaps[current];
+	SpectateSnapshot &base = snaps[current ^ 1];
+	cur.capture(h);
+	bool keyframe = keyframeDue;
+	int written = spectateEncode(cur, keyframe ? NULL : &base, packet);
+	if ((int)packet.size() > SPECTATE_MAX_PACKET) {
+		//nothing was sent, so the next delta would build on nothing
+		stats.dropped++;
+		keyframeDue = true;
+		Log("spectate: tick %u needs %d bytes, not sent\n", h.tick,
+			(int)packet.size());
+		return;
+	}
+	for (unsigned int i = 0; i < viewers.size(); i++)
+		sendto(sock, &packet[0], packet.size(), 0,
+			(struct sockaddr *)&viewers[i].addr, sizeof viewers[i].addr);
+	stats.packets++;
+	stats.bytes += packet.size();
+	stats.sentEntities += written;
+	for (int k = 0; k < SPECTATE_NKINDS; k++)
+		stats.kindTicks[k] += cur.count[k];
+	if (keyframe) {
+		stats.keyPackets++;
+		stats.keyBytes += packet.size();
+		stats.keyEntities += cur.entities();
+		lastKeyframe = h.tick;
+		keyframeDue = false;
+	} else {
+		stats.deltaEntities += cur.entities();
+	}
+	current ^= 1;
+}
+
+void SpectateServer::report() const
+{
+	if (stats.packets == 0)
+		return;
+	long deltaPackets = stats.packets - stats.keyPackets;
+	long deltaBytes = stats.bytes - stats.keyBytes;
+	long entityTicks = stats.keyEntities + stats.deltaEntities;
+	printf("spectate: %ld packets, %ld bytes, %.1f bytes a tick, "
+		"%.1f kB/s at 60 Hz\n", stats.packets, stats.bytes,
+		(double)stats.bytes / stats.packets,
+		(double)stats.bytes / stats.packets * 60.0 / 1024.0);
+	printf("  %-14s %10s %14s\n", "", "per packet", "per entity");
+	if (stats.keyPackets > 0)
+		printf("  %-14s %10.1f %14.2f\n", "keyframes",
+			(double)stats.keyBytes / stats.keyPackets,
+			stats.keyEntities ?
+			(double)stats.keyBytes / stats.keyEntities : 0.0);
+	if (deltaPackets > 0)
+		printf("  %-14s %10.1f %14.2f\n", "deltas",
+			(double)deltaBytes / deltaPackets,
+			stats.deltaEntities ?
+			(double)deltaBytes / stats.deltaEntities : 0.0);
+	printf("  %-14s %10s %14d\n", "plain floats", "",
+		SPECTATE_RAW_ENTITY);
+	printf("  %.1f entities a tick:", (double)entityTicks / stats.packets);
+	for (int k = 0; k < SPECTATE_NKINDS; k++)
+		printf(" %.1f %s", (double)stats.kindTicks[k] / stats.packets,
+			kindNames[k]);
+	printf("\n  %.1f%% of entities changed a tick, %ld packets too big, "
+		"%ld viewers turned away\n",
+		entityTicks ? 100.0 * stats.sentEntities / entityTicks : 0.0,
+		stats.dropped, stats.refused);
+}
+
+//=============================================================
+// Client, in the viewer
+//=============================================================
+
+SpectateClient::SpectateClient()
+{
+	sock = -1;
+	lastHello = lastResync = 0.0;
+	inSync = false;
+	nonce = 0;
+	packets = bytes = stale = 0;
+	buf.resize(65536);
+}
+
+SpectateClient::~SpectateClient()
+{
+	close();
+}
+
+bool SpectateClient::open(const char *host, int port)
+{
+	struct addrinfo hints, *res = NULL;
+	memset(&hints, 0, sizeof hints);
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	int err = getaddrinfo(host, NULL, &hints, &res);
+	if (err != 0 || !res) {
+		printf("spectate: cannot find %s: %s\n", host, gai_strerror(err));
+		return false;
+	}
+	memcpy(&server, res->ai_addr, sizeof server);
+	server.sin_port = htons(port);
+	freeaddrinfo(res);
+	sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+	if (sock < 0) {
+		printf("spectate: socket: %s\n", strerror(errno));
+		return false;
+	}
+	//connected, so the kernel drops datagrams from anyone but the server
+	//and nobody else can hand the viewer a challenge or a frame
+	if (connect(sock, (struct sockaddr *)&server, sizeof server) < 0) {
+		printf("spectate: connect: %s\n", strerror(errno));
+		::close(sock);
+		sock = -1;
+		return false;
+	}
+	send('H');
+	return true;
+}
+
+void SpectateClient::close()
+{
+	if (sock >= 0) {
+		::close(sock);
+	}
+	sock = -1;
+}
+
+void SpectateClient::send(char what)
+{
+	double now = monotonicSeconds();
+	SpectateHello msg;
+	memset(&msg, 0, sizeof msg);
+	msg.what = what;
+	msg.nonce = nonce;
+	sendto(sock, &msg, sizeof msg, 0, (struct sockaddr *)&server, sizeof server);
+	lastHello = now;
+	if (what == 'K')
+		lastResync = now;
+}
+
+bool SpectateClient::poll()
+{
+	if (sock < 0)
+		return false;
+	bool changed = false;
+	int n;
+	while ((n = recv(sock, &buf[0], buf.size(), 0)) > 0) {
+		if (n == (int)sizeof(SpectateHello) && buf[0] == 'N') {
+			//the server's challenge, join with its nonce
+			SpectateHello challenge;
+			memcpy(&challenge, &buf[0], sizeof challenge);
+			nonce = challenge.nonce;
+			send('H');
+			continue;
+		}
+		packets++;
+		bytes += n;
+		int ret = spectateDecode(&buf[0], n, view);
+		if (ret > 0) {
+			changed = true;
+			inSync = true;
+		} else {
+			stale++;
+			//ask right away, the keyframe is the next packet
+			if (inSync)
+				send('K');
+			inSync = false;
+			//decoding may have stopped half way
+			if (ret < 0)
+				view.clear();
+		}
+	}
+	double now = monotonicSeconds();
+	//and again now and then in case the ask was lost too
+	if (!inSync && now - lastResync > SPECTATE_RESYNC_SECONDS)
+		send('K');
+	else if (now - lastHello > SPECTATE_HELLO_SECONDS)
+		send('H');
+	return changed;
+}
+
+//mirror(): viewer entities are made with the same components as the
+//game's, so renderEnemies(), renderPowerUps() and the bullet pool draw
+//them without knowing. Slots that stay put keep their entity, which
+//keeps enemy sprites animating.
+void SpectateClient::mirror()
+{
+	if (mirrored.size() < view.slots.size()) {
+		mirrored.resize(view.slots.size(), emptySlot);
+		local.resize(view.slots.size(), ECS_NO_ENTITY);
+	}
+	for (unsigned int i = 0; i < mirrored.size(); i++) {
+		const SpectateEntity &v = i < view.slots.size() ? view.slots[i] : emptySlot;
+		SpectateEntity &m = mirrored[i];
+		bool same = v.kind == m.kind && v.generation == m.generation &&
+			v.info == m.info && v.half == m.half;
+		if (same && v.x == m.x && v.y == m.y)
+			continue;
+		if (!same && m.kind != SPECTATE_EMPTY) {
+			world.destroy(local[i]);
+			local[i] = ECS_NO_ENTITY;
+		}
+		m = v;
+		if (v.kind == SPECTATE_EMPTY)
+			continue;
+		if (!same) {
+			Entity e;
+			switch (v.kind) {
+				case SPECTATE_ENEMY:
+					e = world.create(enemyMask());
+					world.get<EnemyInfo>(e)->imageIndex = v.info;
+					world.get<Size>(e)->half = v.half;
+					break;
+				case SPECTATE_SCATTER:
+					e = world.create(scatterShotMask());
+					world.get<Size>(e)->half = v.half;
+					break;
+				case SPECTATE_BULLET:
+					e = world.create(bulletMask());
+					break;
+				default:
+					e = world.create(powerUpMask());
+					world.get<PowerUpInfo>(e)->type = v.info;
+					break;
+			}
+			local[i] = e;
+		}
+		Position *p = world.get<Position>(local[i]);
+		p->x = (float)v.x / SPECTATE_QUANTA;
+		p->y = (float)v.y / SPECTATE_QUANTA;
+	}
+}
+
+void SpectateClient::report() const
+{
+	printf("spectate: received %ld packets, %ld bytes, %ld not used\n",
+		packets, bytes, stale);
+}
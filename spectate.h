@@ -0,0 +1,193 @@
+//Program: spectate.h
+//Live spectator stream for Shiba Survival
+//
+//A second machine can watch a run without the game drawing it twice.
+//With SHIBA_SPECTATE_PORT set the game sends a UDP packet every physics
+//tick to each viewer that has said hello on that port, and
+//./shiba --watch host [port] draws what it receives through the normal
+//render code.
+//
+//A packet carries the shiba, the score line and every enemy, scatter
+//shot, bullet and power-up, keyed by entity index. Positions are
+//rounded to a quarter pixel. Most packets are deltas against the tick
+//before: an entity that did not move costs nothing, one that moved
+//costs its index step and two small numbers, and only new or removed
+//entities are sent in full. Every SPECTATE_KEYFRAME ticks, and whenever
+//a viewer joins or asks after losing a packet, a keyframe sends the
+//whole state again. A viewer drops deltas that are not built on the
+//tick it has, so a lost packet costs a short freeze and never a wrong
+//picture.
+//
+//Nothing is sent to an address until it has shown it can hear the game.
+//A viewer's first hello is answered with a nonce made from its address
+//and a secret, no bigger than the hello itself, and only messages that
+//carry that nonce back join, keep a viewer on the list or ask for a
+//keyframe. A forged source address never sees the nonce, so it cannot
+//turn the stream onto someone else. At most SPECTATE_MAX_VIEWERS watch
+//at once, and the game only listens on loopback unless
+//SHIBA_SPECTATE_ADDR names another local address (0.0.0.0 for all).
+//
+#ifndef SPECTATE_H
+#define SPECTATE_H
+
+#include <vector>
+#include <netinet/in.h>
+#include "ecs.h"
+
+#define SPECTATE_PORT 4434
+#define SPECTATE_ADDR "127.0.0.1"
+#define SPECTATE_MAX_VIEWERS 8
+//physics ticks between keyframes, two seconds
+#define SPECTATE_KEYFRAME 120
+//steps per pixel that positions are rounded to
+#define SPECTATE_QUANTA 4
+//biggest packet sent, anything larger is dropped and logged
+#define SPECTATE_MAX_PACKET 65000
+//a viewer that has not said hello for this many seconds is dropped
+#define SPECTATE_VIEWER_TIMEOUT 5.0
+#define SPECTATE_HELLO_SECONDS 1.0
+#define SPECTATE_RESYNC_SECONDS 0.25
+//length of ./shiba --spectate-test, one minute
+#define SPECTATE_TEST_TICKS 3600
+//the test throws one packet away this often to check the viewer recovers
+#define SPECTATE_TEST_LOSS 500
+//and fails unless the viewer matched the game on at least this share of
+//the ticks, a viewer that never catches up checks nothing
+#define SPECTATE_TEST_MIN_CHECKED 0.9
+//power-up types, one for each of powerUpTextures
+#define SPECTATE_POWERUP_TYPES 4
+
+enum {
+	SPECTATE_ENEMY,
+	SPECTATE_SCATTER,
+	SPECTATE_BULLET,
+	SPECTATE_POWERUP,
+	SPECTATE_NKINDS,
+	SPECTATE_EMPTY = 0xff
+};
+
+//the shiba and the numbers drawn over the game
+struct SpectateHeader {
+	unsigned int tick;
+	bool playing;
+	float x, y;
+	int animation, frame;
+	int score, lives, seconds;
+};
+
+//one entity as a viewer sees it, x and y in quanta
+struct SpectateEntity {
+	unsigned char kind;
+	//enemy image or power-up type
+	unsigned char info;
+	unsigned char half;
+	unsigned short generation;
+	short x, y;
+};
+
+class SpectateSnapshot {
+	public:
+		SpectateHeader head;
+		//indexed by entity index, kind is SPECTATE_EMPTY for gaps
+		std::vector<SpectateEntity> slots;
+		int count[SPECTATE_NKINDS];
+		SpectateSnapshot();
+		void clear();
+		void capture(const SpectateHeader &h);
+		int entities() const;
+};
+
+//spectateEncode(): packet for cur, a keyframe when base is NULL,
+//returns how many entities it wrote out
+int spectateEncode(const SpectateSnapshot &cur, const SpectateSnapshot *base,
+	std::vector<unsigned char> &out);
+//spectateDecode(): applies a packet to view. Returns 1 when applied, 0
+//when it is a delta against a tick view does not have, -1 if broken.
+int spectateDecode(const unsigned char *buf, int len, SpectateSnapshot &view);
+
+//every message a viewer sends, and the server's challenge ('N')
+struct SpectateHello {
+	//'H' hello, 'K' keyframe please
+	char what;
+	char pad[3];
+	//0 until the server has sent one
+	unsigned int nonce;
+};
+
+struct SpectateViewer {
+	struct sockaddr_in addr;
+	double lastHeard;
+};
+
+//bytes and entities sent, for the bandwidth report
+struct SpectateStats {
+	long packets;
+	long bytes;
+	long keyPackets;
+	long keyBytes;
+	long keyEntities;
+	long deltaEntities;
+	long sentEntities;
+	long kindTicks[SPECTATE_NKINDS];
+	long dropped;
+	//joins turned away because the list was full
+	long refused;
+};
+
+class SpectateServer {
+	private:
+		int sock;
+		std::vector<SpectateViewer> viewers;
+		SpectateSnapshot snaps[2];
+		int current;
+		bool keyframeDue;
+		unsigned int lastKeyframe;
+		std::vector<unsigned char> packet;
+		unsigned long long secret;
+		unsigned int nonceFor(const struct sockaddr_in &from) const;
+		void listen();
+	public:
+		SpectateStats stats;
+		SpectateServer();
+		~SpectateServer();
+		//addr is a local address to listen on, SPECTATE_ADDR when NULL
+		bool open(int port, const char *addr = NULL);
+		void close();
+		bool active() const { return sock >= 0; }
+		int viewerCount() const { return viewers.size(); }
+		//capture the world and send it, once per physics tick
+		void publish(const SpectateHeader &h);
+		void report() const;
+};
+
+class SpectateClient {
+	private:
+		int sock;
+		struct sockaddr_in server;
+		double lastHello;
+		double lastResync;
+		bool inSync;
+		unsigned int nonce;
+		std::vector<unsigned char> buf;
+		//what is in the world right now for each remote slot
+		std::vector<SpectateEntity> mirrored;
+		std::vector<Entity> local;
+		void send(char what);
+	public:
+		SpectateSnapshot view;
+		long packets, bytes, stale;
+		SpectateClient();
+		~SpectateClient();
+		bool open(const char *host, int port);
+		void close();
+		int fd() const { return sock; }
+		//reads every waiting packet, true if view changed
+		bool poll();
+		//brings the world in line with view
+		void mirror();
+		void report() const;
+};
+
+extern SpectateServer spectator;
+
+#endif
@@ -0,0 +1,258 @@
+//Program: stress.cpp
+//Entity count stress test for Shiba Survival
+//
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include <GL/glx.h>
+#include "stress.h"
+#include "josephS.h"
+#include "danL.h"
+#include "bullets.h"
+#include "timingwheel.h"
+#include "jobs.h"
+#include "rng.h"
+#include "ecs.h"
+
+enum {
+	PHASE_SPAWN,
+	PHASE_UPDATE,
+	PHASE_COLLIDE,
+	PHASE_RENDER,
+	NUM_PHASES
+};
+
+static const char *phaseNames[NUM_PHASES] = {
+	"spawn", "update", "collide", "render"
+};
+
+//one subsystem: how to fill the world with n of it, and the three
+//per tick phases that cost more as n grows
+struct StressSubsystem {
+	const char *name;
+	void (*populate)(int n);
+	void (*update)();
+	void (*collide)();
+	void (*render)();
+	int (*count)();
+};
+
+static float stressXres, stressYres;
+//far off screen, so enemies and shots never reach the shiba and the
+//count stays the same for the whole measurement
+static const float awayX = -1000.0f, awayY = -1000.0f;
+
+static double stressSeconds()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void resetWorld()
+{
+	enemyController.cleanupEnemies();
+	cleanUpShots();
+	resetPowerUps();
+	bullets.clear();
+	numLivesLeft.setLives(3);
+	rngSeed(1);
+}
+
+//the gun fires every tick it is allowed to, sweeping around the screen
+static void fireBullets()
+{
+	static int shot = 0;
+	float a = shot++ * 0.37f;
+	bullets.fire(stressXres / 2, stressYres / 2, cos(a) * 10.0f, sin(a) * 10.0f);
+}
+
+static void enemyPopulate(int n)
+{
+	enemyController.createEnemy(n, awayX, awayY);
+	bullets.rapidFire(1 << 30);
+}
+static void enemyUpdate()
+{
+	enemyController.updateAllPosition(awayX, awayY);
+}
+static void enemyCollide()
+{
+	static unsigned int tick = 0;
+	fireBullets();
+	bullets.update(++tick, stressXres, stressYres);
+	enemyController.bulletHits();
+}
+static void enemyRender()
+{
+	enemyController.renderEnemies();
+}
+static int enemyCount()
+{
+	return enemyController.count();
+}
+
+//shots burst out of a splitting enemy 20 at a time
+static void shotPopulate(int n)
+{
+	Rng &r = rngStreams[RNG_SCATTER];
+	for (int i = 0; i < n; i += 20)
+		makeShots(r.range(stressXres * 0.25f, stressXres * 0.75f),
+			r.range(stressYres * 0.25f, stressYres * 0.75f));
+}
+static void shotUpdate()
+{
+	//with no enemies out this only moves and culls the shots
+	enemyController.updateAllPosition(awayX, awayY);
+}
+static void shotCollide()
+{
+	enemyController.bulletHits();
+}
+static void shotRender()
+{
+	renderScatterShot();
+}
+static int shotCount()
+{
+	return world.count(scatterShotMask());
+}
+
+//placed from the corner so they land on screen, collected by a shiba
+//that is nowhere near them
+static void powerUpPopulate(int n)
+{
+	for (int type = 0; type < 3; type++)
+		spawnPowerUp(n / 3 + (type < n % 3), type, 0.0f, 0.0f);
+}
+static void powerUpUpdate()
+{
+	gameEvents.tick();
+}
+static void powerUpCollide()
+{
+	powerUpCollision(awayX, awayY);
+}
+static void powerUpRender()
+{
+	renderPowerUps();
+}
+static int powerUpCount()
+{
+	return world.count(powerUpMask());
+}
+
+static StressSubsystem subsystems[] = {
+	{ "enemies", enemyPopulate, enemyUpdate, enemyCollide, enemyRender, enemyCount },
+	{ "scatter shots", shotPopulate, shotUpdate, shotCollide, shotRender, shotCount },
+	{ "power-ups", powerUpPopulate, powerUpUpdate, powerUpCollide, powerUpRender, powerUpCount },
+};
+
+//runStep(): fills the world with n of one subsystem and times it for
+//STRESS_TICKS ticks. ms[PHASE_SPAWN] is the one-off cost of making
+//them, the rest are per tick. Returns the per tick total.
+static double runStep(StressSubsystem &s, int n, double *ms, int *alive)
+{
+	resetWorld();
+	double t0 = stressSeconds();
+	s.populate(n);
+	ms[PHASE_SPAWN] = (stressSeconds() - t0) * 1000.0;
+	*alive = s.count();
+	void (*phase[NUM_PHASES])() = { 0, s.update, s.collide, s.render };
+	for (int p = PHASE_UPDATE; p < NUM_PHASES; p++)
+		ms[p] = 0.0;
+	for (int t = 0; t < STRESS_TICKS; t++) {
+		for (int p = PHASE_UPDATE; p < NUM_PHASES; p++) {
+			t0 = stressSeconds();
+			if (p == PHASE_RENDER)
+				glClear(GL_COLOR_BUFFER_BIT);
+			phase[p]();
+			//wait for the card, or drawing looks free
+			if (p == PHASE_RENDER)
+				glFinish();
+			ms[p] += (stressSeconds() - t0) * 1000.0;
+		}
+	}
+	double total = 0.0;
+	for (int p = PHASE_UPDATE; p < NUM_PHASES; p++) {
+		ms[p] /= STRESS_TICKS;
+		total += ms[p];
+	}
+	return total;
+}
+
+static void printStep(int n, int alive, const double *ms, double total, bool fits)
+{
+	printf("%9d %9d", n, alive);
+	for (int p = 0; p < NUM_PHASES; p++)
+		printf(" %9.3f", ms[p]);
+	printf(" %9.3f   %s\n", total, fits ? "yes" : "no");
+}
+
+//ladder(): doubles until the budget is blown, then halves the gap
+//between the last count that fit and the first that did not
+static int ladder(StressSubsystem &s, double budgetMs, double *best)
+{
+	double ms[NUM_PHASES];
+	int alive;
+	int good = 0, bad = 0;
+	printf("\n%s\n", s.name);
+	printf("%9s %9s", "asked", "alive");
+	for (int p = 0; p < NUM_PHASES; p++)
+		printf(" %9s", phaseNames[p]);
+	printf(" %9s   fits\n", "tick ms");
+	for (int n = STRESS_FIRST_COUNT; n <= STRESS_MAX_COUNT; n *= 2) {
+		double total = runStep(s, n, ms, &alive);
+		bool fits = total <= budgetMs;
+		printStep(n, alive, ms, total, fits);
+		if (!fits) {
+			bad = n;
+			break;
+		}
+		good = n;
+		for (int p = 0; p < NUM_PHASES; p++)
+			best[p] = ms[p];
+	}
+	for (int i = 0; i < STRESS_REFINE && bad > 0 && bad - good > 1; i++) {
+		int n = good + (bad - good) / 2;
+		double total = runStep(s, n, ms, &alive);
+		bool fits = total <= budgetMs;
+		printStep(n, alive, ms, total, fits);
+		if (fits) {
+			good = n;
+			for (int p = 0; p < NUM_PHASES; p++)
+				best[p] = ms[p];
+		} else {
+			bad = n;
+		}
+	}
+	return good;
+}
+
+void stressBenchmark(double budgetMs)
+{
+	const int numSubsystems = sizeof(subsystems) / sizeof(subsystems[0]);
+	int most[numSubsystems];
+	double phases[numSubsystems][NUM_PHASES];
+	stressXres = JoeyGlobal::getInstance()->gameXresolution;
+	stressYres = JoeyGlobal::getInstance()->gameYresolution;
+	printf("tick budget %.3f ms, %d ticks per step, %d workers\n",
+		budgetMs, STRESS_TICKS, jobSystem.workerCount());
+	for (int i = 0; i < numSubsystems; i++) {
+		for (int p = 0; p < NUM_PHASES; p++)
+			phases[i][p] = 0.0;
+		most[i] = ladder(subsystems[i], budgetMs, phases[i]);
+	}
+	printf("\nlargest count that fits in %.3f ms\n", budgetMs);
+	printf("%-14s %9s", "subsystem", "count");
+	for (int p = 0; p < NUM_PHASES; p++)
+		printf(" %9s", phaseNames[p]);
+	printf("\n");
+	for (int i = 0; i < numSubsystems; i++) {
+		printf("%-14s %9d", subsystems[i].name, most[i]);
+		for (int p = 0; p < NUM_PHASES; p++)
+			printf(" %9.3f", phases[i][p]);
+		printf("\n");
+	}
+	resetWorld();
+}
@@ -0,0 +1,23 @@
+//Program: stress.h
+//Entity count stress test for Shiba Survival
+//
+//./shiba --stress [budget_ms] fills the world with one kind of entity at
+//a time, doubling the count until a physics tick plus drawing them no
+//longer fits in the budget (one 60 Hz frame by default), then narrows
+//in on the largest count that still fits. Every step prints how long
+//spawning, updating, collision checks and drawing took, and the last
+//table lists the largest sustainable count for each subsystem.
+//
+#ifndef STRESS_H
+#define STRESS_H
+
+#define STRESS_TICKS 60
+#define STRESS_FIRST_COUNT 64
+//entity ids have 20 bits of index, stay well below that
+#define STRESS_MAX_COUNT (1 << 18)
+//halving steps between the last count that fit and the first that did not
+#define STRESS_REFINE 4
+
+void stressBenchmark(double budgetMs);
+
+#endif
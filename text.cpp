@@ -0,0 +1,136 @@
+//Program: text.cpp
+//Batched bitmap text for Shiba Survival
+//
+//The glyph atlases are the ones libggfonts builds in initialize_fonts(),
+//so labels look exactly like the equivalent ggprint16/ggprint8b call.
+//
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "text.h"
+
+//glyph tables exported by libggfonts, indexed by character - 32
+extern GLuint a16_texture_no;
+extern GLuint a8b_texture_no;
+extern int clen_a16[];
+extern int clen_a8b[];
+extern float tx_a16[][2];
+extern float ty_a16[][2];
+extern float tx_a8b[][2];
+extern float ty_a8b[][2];
+
+#define TEXT_NGLYPHS 128
+
+static const float fontHeight[TEXT_NFONTS] = { 20.0f, 10.0f };
+static std::vector<TextVertex> batch[TEXT_NFONTS];
+
+TextLabel::TextLabel(int f)
+{
+	font = f;
+	left = bot = center = 0;
+	color = 0;
+	text[0] = '\0';
+	valid = false;
+}
+
+void TextLabel::invalidate()
+{
+	valid = false;
+}
+
+void TextLabel::layout()
+{
+	const int *clen = (font == TEXT_FONT16) ? clen_a16 : clen_a8b;
+	float (*tx)[2] = (font == TEXT_FONT16) ? tx_a16 : tx_a8b;
+	float (*ty)[2] = (font == TEXT_FONT16) ? ty_a16 : ty_a8b;
+	float h = fontHeight[font];
+	int len = strlen(text);
+	float x = (float)left;
+	float y = (float)bot;
+	if (center) {
+		for (int i = 0; i < len; i++) {
+			int c = (unsigned char)text[i] - 32;
+			if (c >= 0 && c < TEXT_NGLYPHS)
+				x += clen[c] + 1.0f;
+		}
+		int w = (int)x - left;
+		x = (float)(left - (w >> 1));
+	}
+	unsigned char rgba[4] = {
+		(unsigned char)(color >> 16), (unsigned char)(color >> 8),
+		(unsigned char)color, 255
+	};
+	quads.clear();
+	for (int i = 0; i < len; i++) {
+		int c = (unsigned char)text[i] - 32;
+		if (c < 0 || c >= TEXT_NGLYPHS)
+			continue;
+		float w = (float)clen[c];
+		TextVertex v[4] = {
+			{tx[c][0], ty[c][0], {0}, x,     y},
+			{tx[c][0], ty[c][1], {0}, x,     y + h},
+			{tx[c][1], ty[c][1], {0}, x + w, y + h},
+			{tx[c][1], ty[c][0], {0}, x + w, y}
+		};
+		for (int j = 0; j < 4; j++) {
+			memcpy(v[j].rgba, rgba, 4);
+			quads.push_back(v[j]);
+		}
+		x += w + 1.0f;
+	}
+	valid = true;
+}
+
+void TextLabel::print(Rect *r, int advance, unsigned int cref, const char *fmt, ...)
+{
+	char buf[TEXT_MAX_CHARS];
+	va_list ap;
+	va_start(ap, fmt);
+	vsnprintf(buf, sizeof buf, fmt, ap);
+	va_end(ap);
+	if (!valid || r->left != left || r->bot != bot || r->center != center ||
+		cref != color || strcmp(buf, text) != 0) {
+		left = r->left;
+		bot = r->bot;
+		center = r->center;
+		color = cref;
+		strcpy(text, buf);
+		layout();
+	}
+	batch[font].insert(batch[font].end(), quads.begin(), quads.end());
+	r->bot -= advance;
+}
+
+//screens that clear the frame drop any text queued before the clear
+void textDiscard()
+{
+	for (int i = 0; i < TEXT_NFONTS; i++)
+		batch[i].clear();
+}
+
+void textFlush()
+{
+	const GLuint tex[TEXT_NFONTS] = { a16_texture_no, a8b_texture_no };
+	glEnable(GL_ALPHA_TEST);
+	glAlphaFunc(GL_GREATER, 0.0f);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	for (int i = 0; i < TEXT_NFONTS; i++) {
+		if (batch[i].empty())
+			continue;
+		const TextVertex *v = &batch[i][0];
+		glBindTexture(GL_TEXTURE_2D, tex[i]);
+		glTexCoordPointer(2, GL_FLOAT, sizeof(TextVertex), &v->s);
+		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(TextVertex), v->rgba);
+		glVertexPointer(2, GL_FLOAT, sizeof(TextVertex), &v->x);
+		glDrawArrays(GL_QUADS, 0, batch[i].size());
+		batch[i].clear();
+	}
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_ALPHA_TEST);
+	glColor3f(1.0f, 1.0f, 1.0f);
+}
@@ -0,0 +1,49 @@
+//Program: text.h
+//Batched bitmap text for Shiba Survival
+//
+//TextLabel works like the ggprint functions but keeps the laid out
+//glyph quads between frames, only rebuilding them when the formatted
+//string, position or colour changes. Labels queue their quads and
+//textFlush() draws everything queued with one call per font atlas.
+//
+#ifndef TEXT_H
+#define TEXT_H
+
+#include <GL/glx.h>
+#include <vector>
+#include "fonts.h"
+
+enum {
+	TEXT_FONT16,
+	TEXT_FONT8B,
+	TEXT_NFONTS
+};
+
+#define TEXT_MAX_CHARS 128
+
+struct TextVertex {
+	float s, t;
+	unsigned char rgba[4];
+	float x, y;
+};
+
+class TextLabel {
+	private:
+		int font;
+		int left, bot, center;
+		unsigned int color;
+		char text[TEXT_MAX_CHARS];
+		bool valid;
+		std::vector<TextVertex> quads;
+		void layout();
+	public:
+		TextLabel(int f = TEXT_FONT16);
+		void print(Rect *r, int advance, unsigned int cref, const char *fmt, ...)
+			__attribute__((format(printf, 5, 6)));
+		void invalidate();
+};
+
+void textFlush();
+void textDiscard();
+
+#endif
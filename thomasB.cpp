@@ -5,10 +5,11 @@
 #include <GL/glx.h>
 #include <string.h>
 #include <stdio.h>
-#include <iostream>
-#include <fstream>
-#include <sstream>
+#include "amberZ.h"
+#include "arena.h"
+#include "alloctrack.h"
 #include "fonts.h"
+#include "text.h"
 #include "thomasB.h"
 #define MAXBUTTONS 5
 
@@ -37,397 +38,248 @@ void thomasB (int x, int y, GLuint textid)
 	r.bot = y;
 	r.left = x + 90;
 	r.center = 0;
-	ggprint16(&r, 16, 0xffffffff, "Thomas Basden");
+	static TextLabel name;
+	name.print(&r, 16, 0xffffffff, "Thomas Basden");
 	}
 
-// menu(): function to create the game menu
-void menu(GLenum target, GLuint texture, int xres, int yres)
+// makeButton(): fill in a menu button, done once when the menu is built
+static void makeButton(Button *b, const char *text, int left, int bot)
 {
-	//show the background image
-	glBindTexture(target, texture);
-	glBegin(GL_QUADS);
-		glTexCoord2f(0.0f, 1.0f); glVertex2i(0, 0);
-		glTexCoord2f(0.0f, 0.0f); glVertex2i(0, yres); 
-		glTexCoord2f(1.0f, 0.0f); glVertex2i(xres, yres);
-		glTexCoord2f(1.0f, 1.0f); glVertex2i(xres, 0);
-	glEnd();
+	b->r.width = 140;
+	b->r.height = 60;
+	b->r.left = left;
+	b->r.bot = bot;
+	b->r.right = b->r.left + b->r.width;
+	b->r.top = b->r.bot + b->r.height;
+	b->r.centerx = (b->r.left + b->r.right) / 2;
+	b->r.centery = (b->r.bot + b->r.top) / 2;
+	strcpy(b->text, text);
+	b->over = 0;
+	b->down = 0;
+	b->click = 0;
+	b->color[0] = 0.0f;
+	b->color[1] = 0.8f;
+	b->color[2] = 0.1f;
+	b->dcolor[0] = b->color[0] * 0.5f;
+	b->dcolor[1] = b->color[1] * 0.5f;
+	b->dcolor[2] = b->color[2] * 0.5f;
+	b->text_color = 0x00ffffff;
+	b->dirty = 1;
+}
 
-	glBindTexture(GL_TEXTURE_2D, 0);
-	Rect r;
-	nbuttons=0;
+// Cached vertex data for the menu, rebuilt only for dirty buttons
+static float menuBgVerts[4 * 2];
+static float menuBgTex[4 * 2] = {
+	0.0f, 1.0f,  0.0f, 0.0f,  1.0f, 0.0f,  1.0f, 1.0f
+};
+static float buttonVerts[MAXBUTTONS * 4 * 2];
+static float buttonColors[MAXBUTTONS * 4 * 3];
+static TextLabel buttonText[MAXBUTTONS];
+static int menuXres = 0, menuYres = 0;
+static int menuLocation = -1;
 
-	//size, position, & color
-	button[nbuttons].r.width = 140;
-	button[nbuttons].r.height = 60;
-	button[nbuttons].r.left = 50;
-	button[nbuttons].r.bot = 560;
-	button[nbuttons].r.right =
-		button[nbuttons].r.left + button[nbuttons].r.width;
-	button[nbuttons].r.top = button[nbuttons].r.bot +
-		button[nbuttons].r.height;
-	button[nbuttons].r.centerx = (button[nbuttons].r.left +
-		button[nbuttons].r.right) / 2;
-	button[nbuttons].r.centery = (button[nbuttons].r.bot +
-		button[nbuttons].r.top) / 2;
-	strcpy(button[nbuttons].text, "Play");
-	button[nbuttons].down = 0;
-	button[nbuttons].click = 0;
-	button[nbuttons].color[0] = 0.0f;
-	button[nbuttons].color[1] = 0.8f;
-	button[nbuttons].color[2] = 0.1f;
-	button[nbuttons].dcolor[0] = button[nbuttons].color[0] * 0.5f;
-	button[nbuttons].dcolor[1] = button[nbuttons].color[1] * 0.5f;
-	button[nbuttons].dcolor[2] = button[nbuttons].color[2] * 0.5f;
-	button[nbuttons].text_color = 0x00ffffff;
-	nbuttons++;
+// buildMenu(): lay out the menu once, and again if the window is resized
+static void buildMenu(int xres, int yres)
+{
+	const char *names[MAXBUTTONS] = {
+		"Play", "How to play", "High Scores", "Credits", "Quit"
+	};
+	nbuttons = 0;
+	for (int i = 0; i < MAXBUTTONS; i++) {
+		makeButton(&button[nbuttons], names[i], 50, 560 - i * 120);
+		nbuttons++;
+	}
+	float bg[4 * 2] = {
+		0.0f, 0.0f,  0.0f, (float)yres,
+		(float)xres, (float)yres,  (float)xres, 0.0f
+	};
+	memcpy(menuBgVerts, bg, sizeof bg);
+	menuXres = xres;
+	menuYres = yres;
+}
 
-	button[nbuttons].r.width = 140;
-	button[nbuttons].r.height = 60;
-	button[nbuttons].r.left = 50;
-	button[nbuttons].r.bot = 440;
-	button[nbuttons].r.right =
-		button[nbuttons].r.left + button[nbuttons].r.width;
-	button[nbuttons].r.top = button[nbuttons].r.bot +
-		button[nbuttons].r.height;
-	button[nbuttons].r.centerx = (button[nbuttons].r.left +
-		button[nbuttons].r.right) / 2;
-	button[nbuttons].r.centery = (button[nbuttons].r.bot +
-		button[nbuttons].r.top) / 2;
-	strcpy(button[nbuttons].text, "How to play");
-	button[nbuttons].down = 0;
-	button[nbuttons].click = 0;
-	button[nbuttons].color[0] = 0.0f;
-	button[nbuttons].color[1] = 0.8f;
-	button[nbuttons].color[2] = 0.1f;
-	button[nbuttons].dcolor[0] = button[nbuttons].color[0] * 0.5f;
-	button[nbuttons].dcolor[1] = button[nbuttons].color[1] * 0.5f;
-	button[nbuttons].dcolor[2] = button[nbuttons].color[2] * 0.5f;
-	button[nbuttons].text_color = 0x00ffffff;
-	nbuttons++;
+// updateButton(): refresh the cached quad and colours of one button
+static void updateButton(int i)
+{
+	Button *b = &button[i];
+	float *v = &buttonVerts[i * 4 * 2];
+	v[0] = b->r.left;  v[1] = b->r.bot;
+	v[2] = b->r.left;  v[3] = b->r.top;
+	v[4] = b->r.right; v[5] = b->r.top;
+	v[6] = b->r.right; v[7] = b->r.bot;
+	float *c = (location == i) ? b->dcolor : b->color;
+	for (int j = 0; j < 4; j++)
+		memcpy(&buttonColors[(i * 4 + j) * 3], c, sizeof(float) * 3);
+	b->dirty = 0;
+}
 
-	button[nbuttons].r.width = 140;
-	button[nbuttons].r.height = 60;
-	button[nbuttons].r.left = 50;
-	button[nbuttons].r.bot = 320;
-	button[nbuttons].r.right =
-		button[nbuttons].r.left + button[nbuttons].r.width;
-	button[nbuttons].r.top = button[nbuttons].r.bot +
-		button[nbuttons].r.height;
-	button[nbuttons].r.centerx = (button[nbuttons].r.left +
-		button[nbuttons].r.right) / 2;
-	button[nbuttons].r.centery = (button[nbuttons].r.bot +
-		button[nbuttons].r.top) / 2;
-	strcpy(button[nbuttons].text, "High Scores");
-	button[nbuttons].down = 0;
-	button[nbuttons].click = 0;
-	button[nbuttons].color[0] = 0.0f;
-	button[nbuttons].color[1] = 0.8f;
-	button[nbuttons].color[2] = 0.1f;
-	button[nbuttons].dcolor[0] = button[nbuttons].color[0] * 0.5f;
-	button[nbuttons].dcolor[1] = button[nbuttons].color[1] * 0.5f;
-	button[nbuttons].dcolor[2] = button[nbuttons].color[2] * 0.5f;
-	button[nbuttons].text_color = 0x00ffffff;
-	nbuttons++;
-	
-	button[nbuttons].r.width = 140;
-	button[nbuttons].r.height = 60;
-	button[nbuttons].r.left = 50;
-	button[nbuttons].r.bot = 200;
-	button[nbuttons].r.right =
-		button[nbuttons].r.left + button[nbuttons].r.width;
-	button[nbuttons].r.top = button[nbuttons].r.bot +
-		button[nbuttons].r.height;
-	button[nbuttons].r.centerx = (button[nbuttons].r.left +
-		button[nbuttons].r.right) / 2;
-	button[nbuttons].r.centery = (button[nbuttons].r.bot +
-		button[nbuttons].r.top) / 2;
-	strcpy(button[nbuttons].text, "Credits");
-	button[nbuttons].down = 0;
-	button[nbuttons].click = 0;
-	button[nbuttons].color[0] = 0.0f;
-	button[nbuttons].color[1] = 0.8f;
-	button[nbuttons].color[2] = 0.1f;
-	button[nbuttons].dcolor[0] = button[nbuttons].color[0] * 0.5f;
-	button[nbuttons].dcolor[1] = button[nbuttons].color[1] * 0.5f;
-	button[nbuttons].dcolor[2] = button[nbuttons].color[2] * 0.5f;
-	button[nbuttons].text_color = 0x00ffffff;
-	nbuttons++;
+// menu(): function to draw the game menu
+void menu(GLenum target, GLuint texture, int xres, int yres)
+{
+	if (xres != menuXres || yres != menuYres)
+		buildMenu(xres, yres);
+	if (location != menuLocation) {
+		if (menuLocation >= 0 && menuLocation < nbuttons)
+			button[menuLocation].dirty = 1;
+		if (location >= 0 && location < nbuttons)
+			button[location].dirty = 1;
+		menuLocation = location;
+	}
+	for (int i = 0; i < nbuttons; i++) {
+		if (button[i].dirty)
+			updateButton(i);
+	}
 
-	button[nbuttons].r.width = 140;
-	button[nbuttons].r.height = 60;
-	button[nbuttons].r.left = 50;
-	button[nbuttons].r.bot = 80;
-	button[nbuttons].r.right =
-		button[nbuttons].r.left + button[nbuttons].r.width;
-	button[nbuttons].r.top = button[nbuttons].r.bot +
-		button[nbuttons].r.height;
-	button[nbuttons].r.centerx = (button[nbuttons].r.left +
-		button[nbuttons].r.right) / 2;
-	button[nbuttons].r.centery = (button[nbuttons].r.bot +
-		button[nbuttons].r.top) / 2;
-	strcpy(button[nbuttons].text, "Quit");
-	button[nbuttons].down = 0;
-	button[nbuttons].click = 0;
-	button[nbuttons].color[0] = 0.0f;
-	button[nbuttons].color[1] = 0.8f;
-	button[nbuttons].color[2] = 0.1f;
-	button[nbuttons].dcolor[0] = button[nbuttons].color[0] * 0.5f;
-	button[nbuttons].dcolor[1] = button[nbuttons].color[1] * 0.5f;
-	button[nbuttons].dcolor[2] = button[nbuttons].color[2] * 0.5f;
-	button[nbuttons].text_color = 0x00ffffff;
-	nbuttons++;
+	//show the background image
+	glColor3f(1.0f, 1.0f, 1.0f);
+	glBindTexture(target, texture);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glVertexPointer(2, GL_FLOAT, 0, menuBgVerts);
+	glTexCoordPointer(2, GL_FLOAT, 0, menuBgTex);
+	glDrawArrays(GL_QUADS, 0, 4);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glBindTexture(GL_TEXTURE_2D, 0);
 
 	//draw the buttons
-	for (int i=0; i< MAXBUTTONS; i++) {
-		glColor3f(1.0f, 1.0f, 0.0f);
-			
-		if (location == i) {
-			glColor3fv(button[i].dcolor);
-		} 
-		else {
-			glColor3fv(button[i].color);
-		}
-		
-		glBegin(GL_QUADS);
-			glVertex2i(button[i].r.left,  button[i].r.bot);
-			glVertex2i(button[i].r.left,  button[i].r.top);
-			glVertex2i(button[i].r.right, button[i].r.top);
-			glVertex2i(button[i].r.right, button[i].r.bot);
-		glEnd();
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, 0, buttonVerts);
+	glColorPointer(3, GL_FLOAT, 0, buttonColors);
+	glDrawArrays(GL_QUADS, 0, nbuttons * 4);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
 
+	Rect r;
+	for (int i = 0; i < nbuttons; i++) {
 		r.left = button[i].r.centerx;
 		r.bot  = button[i].r.centery-8;
 		r.center = 1;
-		
-		ggprint16(&r, 0, button[i].text_color, button[i].text);
-	}    
+		buttonText[i].print(&r, 0, button[i].text_color, "%s", button[i].text);
+	}
 }
 
 // howToPlay(): Function to display instructions
 void howToPlay(int xres, int yres)
 {
+	static TextLabel lines[6];
 	glClear(GL_COLOR_BUFFER_BIT);
+	textDiscard();
 
 	Rect howTo;
 	howTo.bot = yres * 0.95f;
 	howTo.left = xres/2;
 	howTo.center = 0;
-	ggprint16(&howTo, 0, 0xffffffff, "How To Play");
+	lines[0].print(&howTo, 0, 0xffffffff, "How To Play");
 	howTo.bot = yres * 0.85f;
 	howTo.left = xres / 4;
-	ggprint16(&howTo, 0, 0xffffffff, "Use the arrow keys to move.");
+	lines[1].print(&howTo, 0, 0xffffffff, "Use the arrow keys to move.");
 	howTo.bot = yres * 0.75f;
 	howTo.left = xres / 4;
-	ggprint16(&howTo, 0, 0xffffffff, "Press space to shoot.");
+	lines[2].print(&howTo, 0, 0xffffffff, "Press space to shoot.");
 	howTo.bot = yres * 0.65f;
 	howTo.left = xres / 4;
-	ggprint16(&howTo, 0, 0xffffffff, "Goals:");
+	lines[3].print(&howTo, 0, 0xffffffff, "Goals:");
 	howTo.bot = yres * 0.55f;
 	howTo.left = xres / 4;
-	ggprint16(&howTo, 20, 0xffffffff, "          Avoid the enemies to stay alive");
+	lines[4].print(&howTo, 20, 0xffffffff, "          Avoid the enemies to stay alive");
 	howTo.bot = yres * 0.45f;
 	howTo.left = xres / 4;
-	ggprint16(&howTo, 20, 0xffffffff, "          Shoot the enemies and collect powerups to increase your score");	
+	lines[5].print(&howTo, 20, 0xffffffff, "          Shoot the enemies and collect powerups to increase your score");
 }
 
 // Get the first place score
-int firstPlace()
+int firstPlace(const ArenaVector<ScoreRow> &scores)
 {
-    std::string result;
-    std::ifstream file("scores.csv");
-	std::string line;
-	std::string name;
 	int highScore = 0;
-    int currentScore = 0;
-	while (getline(file, line)) {
-		std::stringstream ss(line);
-		std::string value;
-		while (std::getline(ss, value, ',')) {
-			name = value;
-			std::getline(ss, value, ',');
-			currentScore = stod(value);
+	for (unsigned int i = 0; i < scores.size(); i++) {
+		if (scores[i].score > highScore){
+			highScore = scores[i].score;
 		}
-        if (currentScore > highScore){
-            highScore = currentScore;
-        }
 	}
-    file.close();
-    return highScore;
+	return highScore;
 }
 
 //Get the second place score
-int secondPlace(int first)
+int secondPlace(const ArenaVector<ScoreRow> &scores, int first)
 {
-    std::string result;
-    std::ifstream file("scores.csv");
-	std::string line;
-	std::string name;
 	int highScore = 0;
-    int currentScore = 0;
-	while (getline(file, line)) {
-		std::stringstream ss(line);
-		std::string value;
-		while (std::getline(ss, value, ',')) {
-			name = value;
-			std::getline(ss, value, ',');
-			currentScore = stod(value);
-            if (currentScore == first){
-                currentScore = 0;
-            }
+	for (unsigned int i = 0; i < scores.size(); i++) {
+		int currentScore = scores[i].score;
+		if (currentScore == first){
+			currentScore = 0;
+		}
+		if (currentScore > highScore){
+			highScore = currentScore;
 		}
-        if (currentScore > highScore){
-            highScore = currentScore;
-        }
 	}
-    file.close();
-    return highScore;
+	return highScore;
 }
 
 //Get the third place score
-int thirdPlace(int first, int second)
+int thirdPlace(const ArenaVector<ScoreRow> &scores, int first, int second)
 {
-    std::string result;
-    std::ifstream file("scores.csv");
-	std::string line;
-	std::string name;
 	int highScore = 0;
-    int currentScore = 0;
-	while (getline(file, line)) {
-		std::stringstream ss(line);
-		std::string value;
-		while (std::getline(ss, value, ',')) {
-			name = value;
-			std::getline(ss, value, ',');
-			currentScore = stod(value);
-            if (currentScore == first || currentScore == second){
-                currentScore = 0;
-            }
+	for (unsigned int i = 0; i < scores.size(); i++) {
+		int currentScore = scores[i].score;
+		if (currentScore == first || currentScore == second){
+			currentScore = 0;
+		}
+		if (currentScore > highScore){
+			highScore = currentScore;
 		}
-        if (currentScore > highScore){
-            highScore = currentScore;
-        }
 	}
-    file.close();
-    return highScore;
+	return highScore;
 }
 
 //Get the position of the current player's score on the leader board
-int playerRank(int score)
+int playerRank(const ArenaVector<ScoreRow> &scores, int score)
 {
 	int rank = 1;
-    std::string result;
-    std::ifstream file("scores.csv");
-	std::string line;
-	std::string name;
-    int currentScore = 0;
-	while (getline(file, line)) {
-		std::stringstream ss(line);
-		std::string value;
-		while (std::getline(ss, value, ',')) {
-			name = value;
-			std::getline(ss, value, ',');
-			currentScore = stod(value);
-            if (currentScore > score){
-                rank++;
-	        }
+	for (unsigned int i = 0; i < scores.size(); i++) {
+		if (scores[i].score > score){
+			rank++;
 		}
 	}
-    file.close();
-    return rank;
+	return rank;
 }
 
-//get the name of the first place user
-std::string firstPlacePlayerName()
+//get the name of the user with the highest score that is not
+//skip1 or skip2, the names point into the frame arena
+const char *placePlayerName(const ArenaVector<ScoreRow> &scores, int skip1, int skip2)
 {
-    std::string result;
-    std::ifstream file("scores.csv");
-	std::string line;
-	std::string name;
-    std::string currentName;
+	const char *name = "";
 	int highScore = 0;
-    int currentScore = 0;
-	while (getline(file, line)) {
-		std::stringstream ss(line);
-		std::string value;
-		while (std::getline(ss, value, ',')) {
-			currentName = value;
-			std::getline(ss, value, ',');
-			currentScore = stod(value);
-	    }    
-        if (currentScore > highScore){
-            highScore = currentScore;
-            name = currentName;
-        }
-	}
-    file.close();
-    return name;
-
-}
-
-//get the name of the second place user
-std::string secondPlacePlayerName(int first)
-{
-    std::string result;
-    std::ifstream file("scores.csv");
-	std::string line;
-	std::string name;
-    std::string currentName;
-	int highScore = 0;
-    int currentScore = 0;
-	while (getline(file, line)) {
-		std::stringstream ss(line);
-		std::string value;
-		while (std::getline(ss, value, ',')) {
-			currentName = value;
-			std::getline(ss, value, ',');
-			currentScore = stod(value);
-            if (currentScore == first){
-                currentScore = 0;
-            }
+	for (unsigned int i = 0; i < scores.size(); i++) {
+		int currentScore = scores[i].score;
+		if (currentScore == skip1 || currentScore == skip2){
+			currentScore = 0;
+		}
+		if (currentScore > highScore){
+			highScore = currentScore;
+			name = scores[i].name;
 		}
-        if (currentScore > highScore){
-            highScore = currentScore;
-            name = currentName;
-        }
 	}
-    file.close();
-    return name;
+	return name;
 }
 
-//get the name of the third place user
-std::string thirdPlacePlayerName(int first, int second)
+//The leaderboard on the game over screen is only re-read from scores.csv
+//after a new score has been stored
+static int gameOverDirty = 1;
+
+void gameOverInvalidate()
 {
-    std::string result;
-    std::ifstream file("scores.csv");
-	std::string line;
-	std::string name;
-    std::string currentName;
-	int highScore = 0;
-    int currentScore = 0;
-	while (getline(file, line)) {
-		std::stringstream ss(line);
-		std::string value;
-		while (std::getline(ss, value, ',')) {
-			currentName = value;
-			std::getline(ss, value, ',');
-			currentScore = stod(value);
-            if (currentScore == first || currentScore == second){
-                currentScore = 0;
-            }
-		}
-        if (currentScore > highScore){
-            highScore = currentScore;
-            name = currentName;
-        }
-	}
-    file.close();
-    return name;
+	gameOverDirty = 1;
 }
 
 //Print out the game over screen
 void gameOver(int xres, int yres, char* user, float score, GLenum target, GLuint texture)
 {
+	ALLOC_PHASE(ALLOC_GAMEOVER);
+	static TextLabel player[3], heading, rows[3][3];
+	static int position, first, second, third;
+	static char firstPlace[64], secondPlace[64], thirdPlace[64];
 	glClear(GL_COLOR_BUFFER_BIT);
+	textDiscard();
 
 	//Print the Game Over image
 	glBindTexture(target, texture);
@@ -438,74 +290,70 @@ void gameOver(int xres, int yres, char* user, float score, GLenum target, GLuint
 		glTexCoord2f(1.0f, 1.0f); glVertex2i(xres/2 + 300, yres-100);
 	glEnd();
 
-	char buffer[100];
-	int temp = score * 1; 
-	snprintf(buffer, sizeof buffer, "%d",temp);
+	//read in the player's rank and the top 3 high scores
+	if (gameOverDirty) {
+		ArenaScope scope;
+		ArenaVector<ScoreRow> scores;
+		readScores(scores);
+		position = playerRank(scores, score);
+		first = ::firstPlace(scores);
+		second = ::secondPlace(scores, first);
+		third = ::thirdPlace(scores, first, second);
+		//scores go sour at the end of the scope, keep copies of the names
+		snprintf(firstPlace, sizeof firstPlace, "%s", placePlayerName(scores, -1, -1));
+		snprintf(secondPlace, sizeof secondPlace, "%s", placePlayerName(scores, first, -1));
+		snprintf(thirdPlace, sizeof thirdPlace, "%s", placePlayerName(scores, first, second));
+		gameOverDirty = 0;
+	}
 
 	// print the current player's information
 	Rect name;
 	name.bot = yres - 300;
 	name.left = xres/2 - 200;
 	name.center = 0;
-	int position = playerRank(score);
-	std::string rank = std::to_string(position);
-	ggprint16(&name, 0, 0xffffffff, rank.c_str());
+	player[0].print(&name, 0, 0xffffffff, "%d", position);
 	name.left = xres/2;
-	ggprint16(&name, 0, 0xffffffff, user);
+	player[1].print(&name, 0, 0xffffffff, "%s", user);
 	name.left = xres/2 + 200;
-	ggprint16(&name, 0, 0xffffffff, buffer);
+	player[2].print(&name, 0, 0xffffffff, "%d", (int)score);
 
-	//read in the top 3 high scores
-	int first = firstPlace();
-    std::string firstPlace = firstPlacePlayerName();
-	int second= secondPlace(first);
-    std::string secondPlace = secondPlacePlayerName(first);
-	int third = thirdPlace(first, second);
-    std::string thirdPlace = thirdPlacePlayerName(first, second);
-	
 	//print out the "high score text"
 	Rect high;
 	high.bot = yres - 400;
 	high.left = xres / 2 - 50;
 	high.center = 0;
-	ggprint16(&high, 0, 0xffffffff, "High Scores");
-	
+	heading.print(&high, 0, 0xffffffff, "High Scores");
+
 	// print out the first place score
 	Rect best;
 	best.bot = yres -450;
 	best.left = xres/2 - 200;
 	best.center = 0;
-	const char* one = "1";
-	ggprint16(&best, 0, 0xffffffff, one);
+	rows[0][0].print(&best, 0, 0xffffffff, "1");
 	best.left = xres/2;
-	ggprint16(&best, 0, 0xffffffff, firstPlace.c_str());
+	rows[0][1].print(&best, 0, 0xffffffff, "%s", firstPlace);
 	best.left = xres/2+ 200;
-	std::string finalResult = std::to_string(first);
-	ggprint16(&best, 0, 0xffffffff, finalResult.c_str());
+	rows[0][2].print(&best, 0, 0xffffffff, "%d", first);
 
 	//print out the second place score
 	Rect secondBest;
 	secondBest.bot = yres - 500;
 	secondBest.left = xres/2 - 200;
 	secondBest.center = 0;
-	const char* two = "2";
-	ggprint16(&secondBest, 0, 0xffffffff, two);
+	rows[1][0].print(&secondBest, 0, 0xffffffff, "2");
 	secondBest.left = xres/2;
-	ggprint16(&secondBest, 0, 0xffffffff, secondPlace.c_str());
+	rows[1][1].print(&secondBest, 0, 0xffffffff, "%s", secondPlace);
 	secondBest.left = xres/2 + 200;
-	std::string secondResult = std::to_string(second);
-	ggprint16(&secondBest, 0, 0xffffffff, secondResult.c_str());
+	rows[1][2].print(&secondBest, 0, 0xffffffff, "%d", second);
 
 	//print out the third place score
 	Rect thirdBest;
 	thirdBest.bot = yres - 550;
 	thirdBest.left = xres/2 - 200;
 	thirdBest.center = 0;
-	const char* three = "3";
-	ggprint16(&thirdBest, 0, 0xffffffff, three);
+	rows[2][0].print(&thirdBest, 0, 0xffffffff, "3");
 	thirdBest.left = xres/2;
-	ggprint16(&thirdBest, 0, 0xffffffff, thirdPlace.c_str());
+	rows[2][1].print(&thirdBest, 0, 0xffffffff, "%s", thirdPlace);
 	thirdBest.left = xres/2 + 200;
-	std::string thirdResult = std::to_string(third);
-	ggprint16(&thirdBest, 0, 0xffffffff, thirdResult.c_str());
-}
\ No newline at end of file
+	rows[2][2].print(&thirdBest, 0, 0xffffffff, "%d", third);
+}
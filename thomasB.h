@@ -11,6 +11,7 @@ typedef struct t_button {
 	int over;
 	int down;
 	int click;
+	int dirty;
 	float color[3];
 	float dcolor[3];
 	unsigned int text_color;
@@ -19,6 +20,7 @@ typedef struct t_button {
 void menu(GLenum target, GLuint texture, int xres, int yres);
 void gameOver(int xres, int yres, char* user, float score, GLenum target, GLuint texture);
 void howToPlay(int xres, int yres);
+void gameOverInvalidate();
 extern int location;
 
 #endif
\ No newline at end of file
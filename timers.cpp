@@ -14,6 +14,8 @@ const double oobillion = 1.0 / 1e9;
 struct timespec timeStart, timeCurrent;
 struct timespec timePause;
 double physicsCountdown=0.0;
+//counts physics steps, used for anything timed in whole ticks
+unsigned int physicsTick=0;
 double timeSpan=0.0;
 //unsigned int upause=0;
 double timeDiff(struct timespec *start, struct timespec *end)
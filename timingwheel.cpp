@@ -0,0 +1,210 @@
+//Program: timingwheel.cpp
+//Hierarchical timing wheel for game events
+//
+#include "timingwheel.h"
+
+TimingWheel gameEvents;
+
+#define HANDLE_INDEX(h) ((h) & 0xffff)
+#define HANDLE_SERIAL(h) (((h) >> 16) & 0x7fff)
+
+TimingWheel::TimingWheel()
+{
+	now = 0;
+	count = 0;
+	freeList = -1;
+	for (int i = 0; i < WHEEL_LEVELS * WHEEL_SLOTS; i++)
+		heads[i] = -1;
+}
+
+//link(): put a timer in the slot for how far away it is
+void TimingWheel::link(int id)
+{
+	WheelTimer *t = &timers[id];
+	unsigned int diff = t->when - now;
+	int level = 0;
+	while (level < WHEEL_LEVELS - 1 && diff >= (1u << (WHEEL_BITS * (level + 1))))
+		level++;
+	int slot = level * WHEEL_SLOTS +
+		((t->when >> (WHEEL_BITS * level)) & WHEEL_MASK);
+	t->slot = slot;
+	t->prev = -1;
+	t->next = heads[slot];
+	if (t->next != -1)
+		timers[t->next].prev = id;
+	heads[slot] = id;
+}
+
+void TimingWheel::unlink(int id)
+{
+	WheelTimer *t = &timers[id];
+	if (t->prev != -1)
+		timers[t->prev].next = t->next;
+	else
+		heads[t->slot] = t->next;
+	if (t->next != -1)
+		timers[t->next].prev = t->prev;
+	t->slot = -1;
+}
+
+int TimingWheel::schedule(unsigned int delay, WheelCallback fn, void *ctx)
+{
+	unsigned int limit = (1u << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+	if (delay < 1)
+		delay = 1;
+	if (delay > limit)
+		delay = limit;
+	int id;
+	if (freeList != -1) {
+		id = freeList;
+		freeList = timers[id].next;
+	} else {
+		id = timers.size();
+		WheelTimer t;
+		t.serial = 0;
+		timers.push_back(t);
+	}
+	WheelTimer *t = &timers[id];
+	t->when = now + delay;
+	t->fn = fn;
+	t->ctx = ctx;
+	t->serial = (t->serial + 1) & 0x7fff;
+	link(id);
+	count++;
+	return (t->serial << 16) | id;
+}
+
+void TimingWheel::cancel(int handle)
+{
+	if (handle < 0)
+		return;
+	int id = HANDLE_INDEX(handle);
+	if (id >= (int)timers.size())
+		return;
+	WheelTimer *t = &timers[id];
+	if (t->serial != HANDLE_SERIAL(handle) || t->slot == -1)
+		return;
+	unlink(id);
+	t->next = freeList;
+	freeList = id;
+	count--;
+}
+
+//cascade(): the wheel below wrapped, spread this slot back out
+void TimingWheel::cascade(int level)
+{
+	int slot = level * WHEEL_SLOTS + ((now >> (WHEEL_BITS * level)) & WHEEL_MASK);
+	int id = heads[slot];
+	heads[slot] = -1;
+	while (id != -1) {
+		int next = timers[id].next;
+		link(id);
+		id = next;
+	}
+}
+
+//tick(): move on one tick and fire everything due
+void TimingWheel::tick()
+{
+	now++;
+	if (count == 0)
+		return;
+	for (int level = 1; level < WHEEL_LEVELS; level++) {
+		if ((now >> (WHEEL_BITS * (level - 1))) & WHEEL_MASK)
+			break;
+		cascade(level);
+	}
+	//callbacks may schedule more events, those never land in this slot
+	int slot = now & WHEEL_MASK;
+	while (heads[slot] != -1) {
+		int id = heads[slot];
+		WheelTimer *t = &timers[id];
+		WheelCallback fn = t->fn;
+		void *ctx = t->ctx;
+		unlink(id);
+		t->next = freeList;
+		freeList = id;
+		count--;
+		fn(ctx);
+	}
+}
+
+void TimingWheel::clear()
+{
+	timers.clear();
+	freeList = -1;
+	count = 0;
+	for (int i = 0; i < WHEEL_LEVELS * WHEEL_SLOTS; i++)
+		heads[i] = -1;
+}
+
+//what a timer looks like in a snapshot
+struct SavedTimer {
+	unsigned int when;
+	int fn;
+	long ctx;
+	int next;
+	int prev;
+	int slot;
+	unsigned short serial;
+};
+
+bool TimingWheel::saveState(StateWriter &w, const WheelCallback *known,
+		int nknown) const
+{
+	std::vector<SavedTimer> saved(timers.size());
+	for (unsigned int i = 0; i < timers.size(); i++) {
+		const WheelTimer &t = timers[i];
+		SavedTimer &s = saved[i];
+		s.when = t.when;
+		s.fn = -1;
+		s.ctx = 0;
+		if (t.slot != -1) {
+			for (int k = 0; k < nknown; k++) {
+				if (known[k] == t.fn)
+					s.fn = k;
+			}
+			if (s.fn < 0)
+				return false;
+			s.ctx = (long)t.ctx;
+		}
+		s.next = t.next;
+		s.prev = t.prev;
+		s.slot = t.slot;
+		s.serial = t.serial;
+	}
+	w.put(now);
+	w.put(count);
+	w.put(freeList);
+	w.put(heads);
+	w.putVector(saved);
+	return true;
+}
+
+bool TimingWheel::loadState(StateReader &r, const WheelCallback *known,
+		int nknown)
+{
+	std::vector<SavedTimer> saved;
+	r.get(now);
+	r.get(count);
+	r.get(freeList);
+	r.get(heads);
+	r.getVector(saved);
+	timers.resize(saved.size());
+	for (unsigned int i = 0; i < saved.size(); i++) {
+		const SavedTimer &s = saved[i];
+		WheelTimer &t = timers[i];
+		if (s.fn >= nknown)
+			r.bad = true;
+		t.when = s.when;
+		t.fn = s.fn >= 0 && s.fn < nknown ? known[s.fn] : 0;
+		t.ctx = (void *)s.ctx;
+		t.next = s.next;
+		t.prev = s.prev;
+		t.slot = s.slot;
+		t.serial = s.serial;
+	}
+	if (r.bad)
+		clear();
+	return !r.bad;
+}
@@ -0,0 +1,64 @@
+//Program: timingwheel.h
+//Hierarchical timing wheel for game events
+//
+//Events are scheduled a whole number of physics ticks ahead and fire a
+//callback when that tick comes round. Four wheels of 64 slots cover
+//2^24 ticks (over 3 days at 60 ticks a second). Near events sit in the
+//first wheel and later ones are moved down a wheel each time the one
+//below wraps, so a tick with nothing due costs the same however many
+//events are waiting.
+//
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <vector>
+#include "snapshot.h"
+
+#define WHEEL_LEVELS 4
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+
+typedef void (*WheelCallback)(void *);
+
+struct WheelTimer {
+	unsigned int when;
+	WheelCallback fn;
+	void *ctx;
+	int next;
+	int prev;
+	int slot;
+	unsigned short serial;
+};
+
+class TimingWheel {
+	private:
+		std::vector<WheelTimer> timers;
+		int freeList;
+		int heads[WHEEL_LEVELS * WHEEL_SLOTS];
+		unsigned int now;
+		int count;
+		void link(int id);
+		void unlink(int id);
+		void cascade(int level);
+	public:
+		TimingWheel();
+		//returns a handle for cancel(), delay is in ticks and at least 1
+		int schedule(unsigned int delay, WheelCallback fn, void *ctx);
+		//cancelling a handle that already fired does nothing
+		void cancel(int handle);
+		void tick();
+		void clear();
+		unsigned int time() const { return now; }
+		int pending() const { return count; }
+		//callbacks are saved as their place in known and contexts as
+		//plain numbers, so only events with a number for a context and
+		//a callback from known can be saved
+		bool saveState(StateWriter &w, const WheelCallback *known, int nknown) const;
+		bool loadState(StateReader &r, const WheelCallback *known, int nknown);
+};
+
+//game time, only moves while a game is being played
+extern TimingWheel gameEvents;
+
+#endif
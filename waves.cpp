@@ -0,0 +1,183 @@
+//Program: waves.cpp
+//Wave schedule for Shiba Survival
+//
+//File format, one command per line, # starts a comment:
+//
+//  keepalive N                         spawn N whenever the screen is empty
+//  at T spawn N                        spawn N enemies T seconds in
+//  at T cap N                          allow at most N enemies from then on
+//  every P from A to B spawn N [grow G]
+//  every P from A to B cap N [grow G]  repeat every P seconds from A up to
+//                                      B, adding G to N each time
+//
+//T and A are seconds from 0 to WAVE_MAX_SECONDS and P is at least one
+//tick. A line outside that is not understood, like a misspelt one.
+//
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "waves.h"
+#include "log.h"
+
+WaveSchedule waves;
+
+//used when the schedule file is missing or broken
+static const char *fallbackWaves =
+	"keepalive 5\n"
+	"at 0 cap 10\n";
+
+WaveSchedule::WaveSchedule()
+{
+	cursor = 0;
+	now = 0;
+	keepAlive = 0;
+}
+
+void WaveSchedule::add(double seconds, int type, int value)
+{
+	WaveEvent e;
+	e.tick = (unsigned int)(seconds * WAVE_TICKS_PER_SECOND + 0.5);
+	e.type = type;
+	e.value = value;
+	events.push_back(e);
+}
+
+//inSchedule(): false for negative times, times past the end and NaN,
+//none of which fit the unsigned tick add() turns them into
+static bool inSchedule(double seconds)
+{
+	return seconds >= 0.0 && seconds <= WAVE_MAX_SECONDS;
+}
+
+static int waveType(const char *word)
+{
+	if (strcmp(word, "spawn") == 0)
+		return WAVE_SPAWN;
+	if (strcmp(word, "cap") == 0)
+		return WAVE_CAP;
+	return -1;
+}
+
+bool WaveSchedule::parseLine(const char *line, int lineNo)
+{
+	char what[16];
+	double t, period, from, to, grow = 0.0;
+	int n;
+	while (*line == ' ' || *line == '\t')
+		line++;
+	if (*line == '#' || *line == '\n' || *line == '\r' || *line == '\0')
+		return true;
+	if (sscanf(line, "keepalive %d", &n) == 1) {
+		keepAlive = n;
+		return true;
+	}
+	if (sscanf(line, "at %lf %15s %d", &t, what, &n) == 3 &&
+			waveType(what) >= 0 && inSchedule(t)) {
+		add(t, waveType(what), n);
+		return true;
+	}
+	if (sscanf(line, "every %lf from %lf to %lf %15s %d grow %lf",
+			&period, &from, &to, what, &n, &grow) >= 5 &&
+			waveType(what) >= 0 && inSchedule(from) &&
+			period >= 1.0 / WAVE_TICKS_PER_SECOND) {
+		if (to > WAVE_MAX_SECONDS)
+			to = WAVE_MAX_SECONDS;
+		for (int i = 0; from + i * period <= to; i++)
+			add(from + i * period, waveType(what), n + (int)(i * grow));
+		return true;
+	}
+	Log("waves: line %d not understood: %s\n", lineNo, line);
+	return false;
+}
+
+//finish(): sort into play order, events on the same tick keep their
+//order from the file
+void WaveSchedule::finish()
+{
+	std::stable_sort(events.begin(), events.end(),
+		[](const WaveEvent &a, const WaveEvent &b) { return a.tick < b.tick; });
+	restart();
+}
+
+bool WaveSchedule::loadString(const char *text)
+{
+	events.clear();
+	keepAlive = 0;
+	char line[256];
+	int lineNo = 0;
+	bool ok = true;
+	while (*text) {
+		const char *end = strchr(text, '\n');
+		int len = end ? end - text : strlen(text);
+		if (len > (int)sizeof(line) - 1)
+			len = sizeof(line) - 1;
+		memcpy(line, text, len);
+		line[len] = '\0';
+		ok = parseLine(line, ++lineNo) && ok;
+		text = end ? end + 1 : text + strlen(text);
+	}
+	finish();
+	return ok;
+}
+
+bool WaveSchedule::load(const char *path)
+{
+	FILE *fp = fopen(path, "r");
+	if (!fp) {
+		Log("waves: cannot open %s, using the built in schedule\n", path);
+		loadString(fallbackWaves);
+		return false;
+	}
+	events.clear();
+	keepAlive = 0;
+	char line[256];
+	int lineNo = 0;
+	bool ok = true;
+	while (fgets(line, sizeof line, fp))
+		ok = parseLine(line, ++lineNo) && ok;
+	fclose(fp);
+	if (!ok) {
+		Log("waves: errors in %s, using the built in schedule\n", path);
+		loadString(fallbackWaves);
+		return false;
+	}
+	finish();
+	Log("waves: %d events from %s\n", size(), path);
+	return true;
+}
+
+void WaveSchedule::restart()
+{
+	cursor = 0;
+	now = 0;
+}
+
+int WaveSchedule::step(const WaveEvent **due)
+{
+	unsigned int first = cursor;
+	while (cursor < events.size() && events[cursor].tick <= now)
+		cursor++;
+	now++;
+	*due = events.empty() ? 0 : &events[0] + first;
+	return cursor - first;
+}
+
+void WaveSchedule::saveState(StateWriter &w) const
+{
+	w.put(now);
+}
+
+//the cursor is found again from the tick, so a schedule file edited
+//between save and load picks up where the new file says
+bool WaveSchedule::loadState(StateReader &r)
+{
+	unsigned int tick = 0;
+	r.get(tick);
+	if (r.bad)
+		return false;
+	now = tick;
+	cursor = 0;
+	while (cursor < events.size() && events[cursor].tick < now)
+		cursor++;
+	return true;
+}
@@ -0,0 +1,59 @@
+//Program: waves.h
+//Wave schedule for Shiba Survival
+//
+//The schedule file lists when enemies arrive and how many may be on
+//screen at once, in seconds of play. Loading expands every line into
+//single events at whole physics ticks and sorts them, so playing the
+//schedule is just a cursor moving forward one tick at a time. The same
+//file gives the same game however fast frames are drawn.
+//
+#ifndef WAVES_H
+#define WAVES_H
+
+#include <vector>
+#include "snapshot.h"
+
+#define WAVE_FILE "waves.txt"
+#define WAVE_TICKS_PER_SECOND 60
+//longest schedule we will expand, one hour of play
+#define WAVE_MAX_SECONDS 3600
+
+enum {
+	WAVE_SPAWN,
+	WAVE_CAP
+};
+
+struct WaveEvent {
+	unsigned int tick;
+	int type;
+	int value;
+};
+
+class WaveSchedule {
+	private:
+		std::vector<WaveEvent> events;
+		unsigned int cursor;
+		unsigned int now;
+		int keepAlive;
+		bool parseLine(const char *line, int lineNo);
+		void add(double seconds, int type, int value);
+		void finish();
+	public:
+		WaveSchedule();
+		bool load(const char *path);
+		bool loadString(const char *text);
+		//back to the start for a new game
+		void restart();
+		//moves on one tick, *due points at the events for it
+		int step(const WaveEvent **due);
+		//enemies sent in whenever the screen is empty
+		int keepAliveCount() const { return keepAlive; }
+		int size() const { return events.size(); }
+		//only the tick is saved, the events come from the file
+		void saveState(StateWriter &w) const;
+		bool loadState(StateReader &r);
+};
+
+extern WaveSchedule waves;
+
+#endif